@@ -0,0 +1,47 @@
+//
+//  Frustum.cpp
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/02/09.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#include "Frustum.h"
+#include <math.h>
+
+namespace myTools {
+
+    bool Frustum::IsVisible(const Vector3& center, float radius) const {
+        for(int i = 0; i < PlaneNum; ++i){
+            const Vector4& plane = planes[i];
+            if(plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -radius){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Frustum MakeFrustum(const Matrix4x4& matViewProj){
+        Matrix4x4 mat = matViewProj;
+        Vector4 row0 = mat.row(0);
+        Vector4 row1 = mat.row(1);
+        Vector4 row2 = mat.row(2);
+        Vector4 row3 = mat.row(3);
+        Frustum frustum;
+        frustum.planes[Frustum::Left] = row3 + row0;
+        frustum.planes[Frustum::Right] = row3 - row0;
+        frustum.planes[Frustum::Bottom] = row3 + row1;
+        frustum.planes[Frustum::Top] = row3 - row1;
+        frustum.planes[Frustum::Near] = row3 + row2;
+        frustum.planes[Frustum::Far] = row3 - row2;
+        //距離で比べられるように法線の長さで割る
+        for(auto& plane : frustum.planes){
+            float length = sqrtf(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+            if(length > 0.0f){
+                plane = plane / length;
+            }
+        }
+        return frustum;
+    }
+
+}// namespace myTools
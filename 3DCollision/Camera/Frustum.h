@@ -0,0 +1,46 @@
+//
+//  Frustum.h
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/02/09.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#ifndef Frustum_h
+#define Frustum_h
+
+#include "Vector.h"
+#include "Matrix.h"
+
+namespace myTools {
+
+    /**
+     *  @tips   View frustum. planes are six inward facing planes (a, b, c, d).
+     *          p is inside a plane when dot(abc, p) + d >= 0. abc is normalized
+     */
+    struct Frustum {
+        enum PlaneIndex {
+            Left,
+            Right,
+            Bottom,
+            Top,
+            Near,
+            Far,
+            PlaneNum,
+        };
+        Vector4 planes[PlaneNum];
+
+        //球が少しでも内側にかかっていれば true
+        bool IsVisible(const Vector3& center, float radius) const;
+    };
+
+    /**
+     *  @tips   Extract the frustum from Perspective * ViewMat (* Model) (Gribb / Hartmann).
+     *          The near plane is taken for a -1 to 1 depth range, so a 0 to 1 Perspective
+     *          never culls anything that is visible
+     */
+    Frustum MakeFrustum(const Matrix4x4& matViewProj);
+
+}// namespace myTools
+
+#endif /* Frustum_h */
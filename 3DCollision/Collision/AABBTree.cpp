@@ -0,0 +1,319 @@
+//
+//  AABBTree.cpp
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/20.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#include "AABBTree.h"
+#include <algorithm>
+
+namespace myTools {
+
+    bool Contains(const AABBCollision& outer, const AABBCollision& inner){
+        return outer.min.x <= inner.min.x && inner.max.x <= outer.max.x &&
+        outer.min.y <= inner.min.y && inner.max.y <= outer.max.y &&
+        outer.min.z <= inner.min.z && inner.max.z <= outer.max.z;
+    }
+
+    AABBCollision Combine(const AABBCollision& a, const AABBCollision& b){
+        AABBCollision ret;
+        ret.min = Vector3(std::min(a.min.x, b.min.x), std::min(a.min.y, b.min.y), std::min(a.min.z, b.min.z));
+        ret.max = Vector3(std::max(a.max.x, b.max.x), std::max(a.max.y, b.max.y), std::max(a.max.z, b.max.z));
+        return ret;
+    }
+
+    float SurfaceArea(const AABBCollision& aabb){
+        Vector3 d = aabb.max - aabb.min;
+        return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+    }
+
+    AABBTree::AABBTree(float margin) : margin(margin){
+    }
+
+    int AABBTree::AllocateNode(){
+        if(freeList == nullNode){
+            nodes.push_back(Node());
+            return (int)nodes.size() - 1;
+        }
+        int nodeId = freeList;
+        freeList = nodes[nodeId].parent;
+        nodes[nodeId] = Node();
+        return nodeId;
+    }
+
+    void AABBTree::FreeNode(int nodeId){
+        nodes[nodeId].parent = freeList;
+        nodes[nodeId].height = -1;
+        freeList = nodeId;
+    }
+
+    int AABBTree::CreateProxy(const AABBCollision& aabb, int userData){
+        int proxyId = AllocateNode();
+        Vector3 fat(margin, margin, margin);
+        nodes[proxyId].aabb.min = aabb.min - fat;
+        nodes[proxyId].aabb.max = aabb.max + fat;
+        nodes[proxyId].userData = userData;
+        nodes[proxyId].height = 0;
+        InsertLeaf(proxyId);
+        ++proxyCount;
+        return proxyId;
+    }
+
+    void AABBTree::DestroyProxy(int proxyId){
+        RemoveLeaf(proxyId);
+        FreeNode(proxyId);
+        --proxyCount;
+    }
+
+    bool AABBTree::MoveProxy(int proxyId, const AABBCollision& aabb){
+        if(Contains(nodes[proxyId].aabb, aabb)){
+            return false;
+        }
+        RemoveLeaf(proxyId);
+        Vector3 fat(margin, margin, margin);
+        nodes[proxyId].aabb.min = aabb.min - fat;
+        nodes[proxyId].aabb.max = aabb.max + fat;
+        InsertLeaf(proxyId);
+        return true;
+    }
+
+    void AABBTree::InsertLeaf(int leaf){
+        if(root == nullNode){
+            root = leaf;
+            nodes[root].parent = nullNode;
+            return;
+        }
+
+        //表面積が一番増えない兄弟を探す
+        AABBCollision leafAABB = nodes[leaf].aabb;
+        int index = root;
+        while(!nodes[index].IsLeaf()){
+            int child1 = nodes[index].child1;
+            int child2 = nodes[index].child2;
+
+            float area = SurfaceArea(nodes[index].aabb);
+            float combinedArea = SurfaceArea(Combine(nodes[index].aabb, leafAABB));
+
+            //ここに新しい親を作る場合のコスト
+            float cost = 2.0f * combinedArea;
+            //子に降りる場合に上の階層で増える分のコスト
+            float inheritanceCost = 2.0f * (combinedArea - area);
+
+            auto descendCost = [&](int child){
+                float newArea = SurfaceArea(Combine(leafAABB, nodes[child].aabb));
+                if(nodes[child].IsLeaf()){
+                    return newArea + inheritanceCost;
+                }
+                return (newArea - SurfaceArea(nodes[child].aabb)) + inheritanceCost;
+            };
+            float cost1 = descendCost(child1);
+            float cost2 = descendCost(child2);
+
+            if(cost < cost1 && cost < cost2){
+                break;
+            }
+            index = cost1 < cost2 ? child1 : child2;
+        }
+        int sibling = index;
+
+        int oldParent = nodes[sibling].parent;
+        int newParent = AllocateNode();
+        nodes[newParent].parent = oldParent;
+        nodes[newParent].aabb = Combine(leafAABB, nodes[sibling].aabb);
+        nodes[newParent].height = nodes[sibling].height + 1;
+        nodes[newParent].child1 = sibling;
+        nodes[newParent].child2 = leaf;
+        nodes[sibling].parent = newParent;
+        nodes[leaf].parent = newParent;
+
+        if(oldParent != nullNode){
+            if(nodes[oldParent].child1 == sibling){
+                nodes[oldParent].child1 = newParent;
+            }
+            else {
+                nodes[oldParent].child2 = newParent;
+            }
+        }
+        else {
+            root = newParent;
+        }
+
+        //親をたどってAABBと高さを直す
+        index = nodes[leaf].parent;
+        while(index != nullNode){
+            index = Balance(index);
+            int child1 = nodes[index].child1;
+            int child2 = nodes[index].child2;
+            nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+            nodes[index].aabb = Combine(nodes[child1].aabb, nodes[child2].aabb);
+            index = nodes[index].parent;
+        }
+    }
+
+    void AABBTree::RemoveLeaf(int leaf){
+        if(leaf == root){
+            root = nullNode;
+            return;
+        }
+
+        int parent = nodes[leaf].parent;
+        int grandParent = nodes[parent].parent;
+        int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+        if(grandParent != nullNode){
+            if(nodes[grandParent].child1 == parent){
+                nodes[grandParent].child1 = sibling;
+            }
+            else {
+                nodes[grandParent].child2 = sibling;
+            }
+            nodes[sibling].parent = grandParent;
+            FreeNode(parent);
+
+            int index = grandParent;
+            while(index != nullNode){
+                index = Balance(index);
+                int child1 = nodes[index].child1;
+                int child2 = nodes[index].child2;
+                nodes[index].aabb = Combine(nodes[child1].aabb, nodes[child2].aabb);
+                nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+                index = nodes[index].parent;
+            }
+        }
+        else {
+            root = sibling;
+            nodes[sibling].parent = nullNode;
+            FreeNode(parent);
+        }
+    }
+
+    //高さの差が2以上ある場合に回転させる
+    int AABBTree::Balance(int iA){
+        Node* A = &nodes[iA];
+        if(A->IsLeaf() || A->height < 2){
+            return iA;
+        }
+
+        int iB = A->child1;
+        int iC = A->child2;
+        Node* B = &nodes[iB];
+        Node* C = &nodes[iC];
+
+        int balance = C->height - B->height;
+
+        //Cを上げる
+        if(balance > 1){
+            int iF = C->child1;
+            int iG = C->child2;
+            Node* F = &nodes[iF];
+            Node* G = &nodes[iG];
+
+            C->child1 = iA;
+            C->parent = A->parent;
+            A->parent = iC;
+
+            if(C->parent != nullNode){
+                if(nodes[C->parent].child1 == iA){
+                    nodes[C->parent].child1 = iC;
+                }
+                else {
+                    nodes[C->parent].child2 = iC;
+                }
+            }
+            else {
+                root = iC;
+            }
+
+            if(F->height > G->height){
+                C->child2 = iF;
+                A->child2 = iG;
+                G->parent = iA;
+                A->aabb = Combine(B->aabb, G->aabb);
+                C->aabb = Combine(A->aabb, F->aabb);
+                A->height = 1 + std::max(B->height, G->height);
+                C->height = 1 + std::max(A->height, F->height);
+            }
+            else {
+                C->child2 = iG;
+                A->child2 = iF;
+                F->parent = iA;
+                A->aabb = Combine(B->aabb, F->aabb);
+                C->aabb = Combine(A->aabb, G->aabb);
+                A->height = 1 + std::max(B->height, F->height);
+                C->height = 1 + std::max(A->height, G->height);
+            }
+            return iC;
+        }
+
+        //Bを上げる
+        if(balance < -1){
+            int iD = B->child1;
+            int iE = B->child2;
+            Node* D = &nodes[iD];
+            Node* E = &nodes[iE];
+
+            B->child1 = iA;
+            B->parent = A->parent;
+            A->parent = iB;
+
+            if(B->parent != nullNode){
+                if(nodes[B->parent].child1 == iA){
+                    nodes[B->parent].child1 = iB;
+                }
+                else {
+                    nodes[B->parent].child2 = iB;
+                }
+            }
+            else {
+                root = iB;
+            }
+
+            if(D->height > E->height){
+                B->child2 = iD;
+                A->child1 = iE;
+                E->parent = iA;
+                A->aabb = Combine(C->aabb, E->aabb);
+                B->aabb = Combine(A->aabb, D->aabb);
+                A->height = 1 + std::max(C->height, E->height);
+                B->height = 1 + std::max(A->height, D->height);
+            }
+            else {
+                B->child2 = iE;
+                A->child1 = iD;
+                D->parent = iA;
+                A->aabb = Combine(C->aabb, D->aabb);
+                B->aabb = Combine(A->aabb, E->aabb);
+                A->height = 1 + std::max(C->height, D->height);
+                B->height = 1 + std::max(A->height, E->height);
+            }
+            return iB;
+        }
+        return iA;
+    }
+
+    void AABBTree::QueryPairs(std::vector<std::pair<int,int>>& pairs) const {
+        pairs.clear();
+        for(int i = 0; i < (int)nodes.size(); ++i){
+            const Node& node = nodes[i];
+            if(node.height != 0){
+                continue;
+            }
+            //ペアの重複を避けるため自分よりidが大きい葉とだけ組む
+            Query(node.aabb, [&](int other){
+                if(other > i){
+                    pairs.emplace_back(node.userData, nodes[other].userData);
+                }
+                return true;
+            });
+        }
+    }
+
+    int AABBTree::GetHeight() const {
+        if(root == nullNode){
+            return 0;
+        }
+        return nodes[root].height;
+    }
+}// namespace myTools
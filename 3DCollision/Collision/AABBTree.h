@@ -0,0 +1,172 @@
+//
+//  AABBTree.h
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/20.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#ifndef AABBTree_h
+#define AABBTree_h
+
+#include "Primitive.h"
+#include <vector>
+#include <utility>
+#include <algorithm>
+
+namespace myTools {
+
+    bool Contains(const AABBCollision& outer, const AABBCollision& inner);
+    AABBCollision Combine(const AABBCollision& a, const AABBCollision& b);
+    float SurfaceArea(const AABBCollision& aabb);
+
+    inline bool IsOverlap(const AABBCollision& a, const AABBCollision& b){
+        return !(a.max.x < b.min.x || a.min.x > b.max.x ||
+                 a.max.y < b.min.y || a.min.y > b.max.y ||
+                 a.max.z < b.min.z || a.min.z > b.max.z);
+    }
+
+    /**
+     *  @tips   Dynamic AABB tree for the broad phase.
+     *          Leaves hold aabbs fattened by margin,
+     *          so small moves do not change the tree
+     */
+    class AABBTree {
+    public:
+        static const int nullNode = -1;
+
+        AABBTree(float margin = 0.5f);
+
+        /**
+         *  @tips   return proxy id. userData is returned by GetUserData and pair queries
+         */
+        int CreateProxy(const AABBCollision& aabb, int userData);
+        void DestroyProxy(int proxyId);
+
+        /**
+         *  @tips   If aabb is still inside the fat aabb, the tree is not changed and return false
+         */
+        bool MoveProxy(int proxyId, const AABBCollision& aabb);
+
+        int GetUserData(int proxyId) const {
+            return nodes[proxyId].userData;
+        }
+        const AABBCollision& GetFatAABB(int proxyId) const {
+            return nodes[proxyId].aabb;
+        }
+
+        /**
+         *  @tips   func(int proxyId) is called for each leaf overlapping aabb.
+         *          If func returns false, the query is stopped.
+         */
+        template<typename Func>
+        void Query(const AABBCollision& aabb, Func func) const;
+
+        /**
+         *  @tips   Collect every overlapping leaf pair as (userData, userData). Each pair appears once.
+         */
+        void QueryPairs(std::vector<std::pair<int,int>>& pairs) const;
+        /**
+         *  @tips   Same as above but skips pairs where isActive(userData) is false for both leaves.
+         *          Only active leaves are queried, so the cost follows the number of active leaves.
+         */
+        template<typename Func>
+        void QueryPairs(std::vector<std::pair<int,int>>& pairs, Func isActive) const;
+
+        int GetHeight() const;
+        int GetProxyCount() const {
+            return proxyCount;
+        }
+        float GetMargin() const {
+            return margin;
+        }
+        void SetMargin(float margin){
+            this->margin = margin;
+        }
+
+    private:
+        struct Node {
+            bool IsLeaf() const {
+                return child1 == nullNode;
+            }
+            AABBCollision aabb;
+            int userData = -1;
+            //空きノードのときは次の空きノードを指す
+            int parent = nullNode;
+            int child1 = nullNode;
+            int child2 = nullNode;
+            //葉は0, 空きノードは-1
+            int height = -1;
+        };
+
+        int AllocateNode();
+        void FreeNode(int nodeId);
+        void InsertLeaf(int leaf);
+        void RemoveLeaf(int leaf);
+        int Balance(int index);
+
+        std::vector<Node> nodes;
+        int root = nullNode;
+        int freeList = nullNode;
+        int proxyCount = 0;
+        float margin;
+    };
+
+    template<typename Func>
+    void AABBTree::Query(const AABBCollision& aabb, Func func) const {
+        if(root == nullNode){
+            return;
+        }
+        //Queryの中でQueryが呼ばれても壊れないようにローカルのスタックを使う
+        //足りなくなったら(木がとても偏ったとき)ヒープに移して伸ばす
+        int localStack[256];
+        std::vector<int> growStack;
+        int* stack = localStack;
+        int capacity = 256;
+        int top = 0;
+        stack[top++] = root;
+        while(top > 0){
+            int nodeId = stack[--top];
+            const Node& node = nodes[nodeId];
+            if(!IsOverlap(node.aabb, aabb)){
+                continue;
+            }
+            if(node.IsLeaf()){
+                if(!func(nodeId)){
+                    return;
+                }
+                continue;
+            }
+            if(top + 2 > capacity){
+                capacity *= 2;
+                growStack.resize(capacity);
+                if(stack == localStack){
+                    std::copy(localStack, localStack + top, growStack.begin());
+                }
+                stack = growStack.data();
+            }
+            stack[top++] = node.child1;
+            stack[top++] = node.child2;
+        }
+    }
+
+    template<typename Func>
+    void AABBTree::QueryPairs(std::vector<std::pair<int,int>>& pairs, Func isActive) const {
+        pairs.clear();
+        for(int i = 0; i < (int)nodes.size(); ++i){
+            const Node& node = nodes[i];
+            if(node.height != 0 || !isActive(node.userData)){
+                continue;
+            }
+            //相手も動いているときは id が大きい方とだけ組む. 止まっている相手とはいつも組む
+            Query(node.aabb, [&](int other){
+                if(other != i && (other > i || !isActive(nodes[other].userData))){
+                    pairs.emplace_back(node.userData, nodes[other].userData);
+                }
+                return true;
+            });
+        }
+    }
+}// namespace myTools
+
+#endif /* AABBTree_h */
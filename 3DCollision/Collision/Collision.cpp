@@ -7,6 +7,7 @@
 //
 
 #include "Collision.h"
+#include "ConvexCollision.h"
 #include <math.h>
 
 namespace myTools {    
@@ -20,6 +21,18 @@ namespace myTools {
     PlaneCollision CastToPlaneCollision(const SquareCollision& square){
         return PlaneCollision(square.p[0], Normalize(cross(square.p[1] - square.p[0], square.p[2] - square.p[1])));
     }
+    AABBCollision CastToAABB(const CubeCollision& cube){
+        AABBCollision aabb;
+        for(int i = 0; i < 3; ++i){
+            float half = 0.0f;
+            for(int j = 0; j < 3; ++j){
+                half += fabsf(cube.direct[j][i]) * cube.scale[j];
+            }
+            aabb.min[i] = cube.position[i] - half;
+            aabb.max[i] = cube.position[i] + half;
+        }
+        return aabb;
+    }
     
     bool IsFront(const PlaneCollision& plane, const Point& point){
         return dot(plane.normal, point - plane.p) >= 0;
@@ -291,7 +304,8 @@ namespace myTools {
             float tmp = Distance(point, squPlane);
             return tmp * tmp;
         }
-        const std::vector<Segment>& sides = square.GetSides();
+        Segment sides[4];
+        square.GetSides(sides);
         float dist = DistanceSq(point, sides[0]);
         float tmp = DistanceSq(point, sides[1]);
         if(tmp < dist){
@@ -1072,7 +1086,9 @@ namespace myTools {
             return true;
         }
         
-        std::vector<Segment> sides = square.GetSides();
+        Segment sides[4];
+        
+        square.GetSides(sides);
         float radSq = cylinder.radius * cylinder.radius;
         return DistanceSq(cylinder.line, sides[0]) <= radSq ||
         DistanceSq(cylinder.line, sides[1]) <= radSq ||
@@ -1461,7 +1477,9 @@ namespace myTools {
     //CubeAABBCollision and Line
     bool CollisionReturnFlag(const AABBCollision& c, const Line& l){
 
-        std::vector<Point> points = c.GetPoints();
+        Point points[8];
+
+        c.GetPoints(points);
         
         SquareCollision square[6];
         square[0].SetPoint(points[0], points[1], points[2], points[3]);
@@ -1489,7 +1507,9 @@ namespace myTools {
         CollisionData result;
         CollisionData buf;
         
-        std::vector<Point> points = c.GetPoints();
+        Point points[8];
+        
+        c.GetPoints(points);
         
         SquareCollision square[6];
         square[0].SetPoint(points[0], points[1], points[2], points[3]);
@@ -1523,7 +1543,9 @@ namespace myTools {
     //CubeAABBCollision and Segment
     bool CollisionReturnFlag(const AABBCollision& c, const Segment& s){
         
-        std::vector<Point> points = c.GetPoints();
+        Point points[8];
+        
+        c.GetPoints(points);
 
         SquareCollision square[6];
         square[0].SetPoint(points[0], points[1], points[2], points[3]);
@@ -1621,7 +1643,9 @@ namespace myTools {
         Vector3 y(0.0f,1.0f,0.0f);
         Vector3 z(0.0f,0.0f,1.0f);
 
-        std::vector<Point> points = cube.GetPoints();
+        Point points[8];
+
+        cube.GetPoints(points);
         
         float t;
         Vector3 pos;
@@ -1770,6 +1794,270 @@ namespace myTools {
         return true;
     }
 
+    //CubeCollision
+    namespace {
+        //辺同士がほぼ平行なときに外積が 0 になって誤判定しないよう回転の絶対値に足す
+        const float CubeParallelEpsilon = 1.0e-6f;
+        //辺同士の軸は面の軸より少し深くないと選ばない(接触の向きが揺れないように)
+        const float CubeEdgeAxisBias = 1.05f;
+        
+        /**
+         *  @tips   cube2 seen in the axes of cube1, shared by all 15 SAT axes.
+         *          r[i][j] = dot(cube1.direct[i], cube2.direct[j])
+         */
+        struct CubeRotation {
+            float r[3][3];
+            float absR[3][3];
+            //cube1 から cube2 の中心(cube1 の軸で)
+            Vector3 center;
+        };
+        
+        void CulcCubeRotation(const CubeCollision& cube1, const CubeCollision& cube2, CubeRotation& rotation){
+            Vector3 toCube2 = cube2.position - cube1.position;
+            for(int i = 0; i < 3; ++i){
+                for(int j = 0; j < 3; ++j){
+                    rotation.r[i][j] = dot(cube1.direct[i], cube2.direct[j]);
+                    rotation.absR[i][j] = fabsf(rotation.r[i][j]) + CubeParallelEpsilon;
+                }
+                rotation.center[i] = dot(toCube2, cube1.direct[i]);
+            }
+        }
+        
+        //分離軸の数. cube1 の面 3 本 -> cube2 の面 3 本 -> 辺同士 9 本の順(分離しやすい順)
+        const int CubeAxisCount = 15;
+        
+        /**
+         *  @tips   The index-th separating axis (in cube1 axes, not normalized) and the sum of the projected radii.
+         *          Returns false when the edges are parallel and there is no axis
+         */
+        bool GetCubeAxis(const CubeCollision& cube1, const CubeCollision& cube2, const CubeRotation& rotation,
+                         int index, Vector3& axis, float& radius){
+            const Vector3& a = cube1.scale;
+            const Vector3& b = cube2.scale;
+            if(index < 3){
+                int i = index;
+                axis = Vector3();
+                axis[i] = 1.0f;
+                radius = a[i] + b.x * rotation.absR[i][0] + b.y * rotation.absR[i][1] + b.z * rotation.absR[i][2];
+                return true;
+            }
+            if(index < 6){
+                int j = index - 3;
+                axis = Vector3(rotation.r[0][j], rotation.r[1][j], rotation.r[2][j]);
+                radius = a.x * rotation.absR[0][j] + a.y * rotation.absR[1][j] + a.z * rotation.absR[2][j] + b[j];
+                return true;
+            }
+            //cube1.direct[i] x cube2.direct[j]
+            int i = (index - 6) / 3;
+            int j = (index - 6) % 3;
+            int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+            int j1 = (j + 1) % 3, j2 = (j + 2) % 3;
+            axis = Vector3();
+            axis[i1] = -rotation.r[i2][j];
+            axis[i2] = rotation.r[i1][j];
+            if(axis.LengthSq() < CubeParallelEpsilon){
+                return false;
+            }
+            radius = a[i1] * rotation.absR[i2][j] + a[i2] * rotation.absR[i1][j] +
+                     b[j1] * rotation.absR[i][j2] + b[j2] * rotation.absR[i][j1];
+            return true;
+        }
+        
+        //cube1 の軸で表した向きを世界の向きへ
+        Vector3 ToWorldDirection(const CubeCollision& cube, const Vector3& local){
+            return cube.direct[0] * local.x + cube.direct[1] * local.y + cube.direct[2] * local.z;
+        }
+    }
+    
+    //CubeCollision and Point
+    bool CollisionReturnFlag(const CubeCollision& cube, const Point& point){
+        Vector3 toPoint = point - cube.position;
+        for(int i = 0; i < 3; ++i){
+            if(fabsf(dot(toPoint, cube.direct[i])) > cube.scale[i]){
+                return false;
+            }
+        }
+        return true;
+    }
+    bool CollisionReturnFlag(const Point& point, const CubeCollision& cube){
+        return CollisionReturnFlag(cube, point);
+    }
+    Point SupClosestPointCube(const CubeCollision& cube, const Point& point){
+        Vector3 toPoint = point - cube.position;
+        Point ret = cube.position;
+        for(int i = 0; i < 3; ++i){
+            float d = dot(toPoint, cube.direct[i]);
+            Clamp(d, -cube.scale[i], cube.scale[i]);
+            ret += cube.direct[i] * d;
+        }
+        return ret;
+    }
+    
+    //CubeCollision and SphereCollision
+    bool CollisionReturnFlag(const CubeCollision& cube, const SphereCollision& sphere){
+        Vector3 toSphere = sphere.position - cube.position;
+        float radiusSq = sphere.radius * sphere.radius;
+        float distSq = 0.0f;
+        for(int i = 0; i < 3; ++i){
+            float over = fabsf(dot(toSphere, cube.direct[i])) - cube.scale[i];
+            if(over > 0.0f){
+                distSq += over * over;
+                //1軸だけで離れていればもう見なくていい
+                if(distSq > radiusSq){
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+    bool CollisionReturnFlag(const SphereCollision& sphere, const CubeCollision& cube){
+        return CollisionReturnFlag(cube, sphere);
+    }
+    
+    //CubeCollision and CapsuleCollision
+    bool CollisionReturnFlag(const CubeCollision& cube, const CapsuleCollision& capsule){
+        //線分の中心と半分の長さを cube の軸で見る
+        Vector3 half = capsule.s.v * 0.5f;
+        Vector3 toCenter = capsule.s.p + half - cube.position;
+        Vector3 localCenter, localHalf, absHalf;
+        for(int i = 0; i < 3; ++i){
+            localCenter[i] = dot(toCenter, cube.direct[i]);
+            localHalf[i] = dot(half, cube.direct[i]);
+            absHalf[i] = fabsf(localHalf[i]);
+        }
+        //cube の面の軸
+        for(int i = 0; i < 3; ++i){
+            if(fabsf(localCenter[i]) > cube.scale[i] + absHalf[i] + capsule.radius){
+                return false;
+            }
+        }
+        //線分 x 面の軸
+        for(int i = 0; i < 3; ++i){
+            int i1 = (i + 1) % 3, i2 = (i + 2) % 3;
+            float dist = fabsf(localCenter[i1] * localHalf[i2] - localCenter[i2] * localHalf[i1]);
+            float radius = cube.scale[i1] * absHalf[i2] + cube.scale[i2] * absHalf[i1];
+            //軸の長さ分だけ capsule の半径も伸ばす
+            float axisLength = sqrtf(localHalf[i1] * localHalf[i1] + localHalf[i2] * localHalf[i2]);
+            if(dist > radius + capsule.radius * axisLength){
+                return false;
+            }
+        }
+        //端の球が当たっていればそれで決まる
+        if(CollisionReturnFlag(cube, SphereCollision(capsule.radius, capsule.s.p)) ||
+           CollisionReturnFlag(cube, SphereCollision(capsule.radius, capsule.s.GetEndPoint()))){
+            return true;
+        }
+        //角や辺の丸いところは軸で分けられないので線分と cube の距離で見る
+        ConvexHitData data = ConvexDistance(CastToConvex(capsule.s), CastToConvex(cube));
+        return data.hit || data.distance <= capsule.radius;
+    }
+    bool CollisionReturnFlag(const CapsuleCollision& capsule, const CubeCollision& cube){
+        return CollisionReturnFlag(cube, capsule);
+    }
+    
+    //CubeCollision and CubeCollision
+    bool CollisionReturnFlag(const CubeCollision& cube1, const CubeCollision& cube2){
+        CubeRotation rotation;
+        CulcCubeRotation(cube1, cube2, rotation);
+        Vector3 axis;
+        float radius;
+        for(int i = 0; i < CubeAxisCount; ++i){
+            if(GetCubeAxis(cube1, cube2, rotation, i, axis, radius) &&
+               fabsf(dot(rotation.center, axis)) > radius){
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    bool SupCubeCubeSAT(const CubeCollision& cube1, const CubeCollision& cube2, Vector3& normal, float& depth){
+        CubeRotation rotation;
+        CulcCubeRotation(cube1, cube2, rotation);
+        Vector3 axis;
+        float radius;
+        float minCompare = 0.0f;
+        Vector3 minAxis;
+        bool isFound = false;
+        for(int i = 0; i < CubeAxisCount; ++i){
+            if(!GetCubeAxis(cube1, cube2, rotation, i, axis, radius)){
+                continue;
+            }
+            float dist = dot(rotation.center, axis);
+            float overlap = radius - fabsf(dist);
+            if(overlap < 0.0f){
+                return false;
+            }
+            float axisLength = axis.Length();
+            overlap /= axisLength;
+            float compare = i < 6 ? overlap : overlap * CubeEdgeAxisBias;
+            if(!isFound || compare < minCompare){
+                isFound = true;
+                minCompare = compare;
+                depth = overlap;
+                minAxis = axis * ((dist < 0.0f ? -1.0f : 1.0f) / axisLength);
+            }
+        }
+        normal = ToWorldDirection(cube1, minAxis);
+        return true;
+    }
+    
+    bool SupAxisOverlapTime(float center, float speed, float radius, float& first, float& last){
+        if(fabsf(speed) < MT_EPSILON){
+            //動かないので最初から重なっているかどうかだけ
+            return fabsf(center) <= radius;
+        }
+        float t1 = (-radius - center) / speed;
+        float t2 = (radius - center) / speed;
+        if(t1 > t2){
+            float tmp = t1;
+            t1 = t2;
+            t2 = tmp;
+        }
+        if(t1 > first){
+            first = t1;
+        }
+        if(t2 < last){
+            last = t2;
+        }
+        return first <= last;
+    }
+    
+    bool SupCubeCubeSweep(const CubeCollision& cube1, const CubeCollision& cube2, const Vector3& vel,
+                          float& t, Vector3& normal, float& depth){
+        CubeRotation rotation;
+        CulcCubeRotation(cube1, cube2, rotation);
+        Vector3 localVel(dot(vel, cube1.direct[0]), dot(vel, cube1.direct[1]), dot(vel, cube1.direct[2]));
+        float first = 0.0f;
+        float last = 1.0f;
+        Vector3 axis;
+        Vector3 hitAxis;
+        float radius;
+        for(int i = 0; i < CubeAxisCount; ++i){
+            if(!GetCubeAxis(cube1, cube2, rotation, i, axis, radius)){
+                continue;
+            }
+            float dist = dot(rotation.center, axis);
+            float speed = dot(localVel, axis);
+            float preFirst = first;
+            if(!SupAxisOverlapTime(dist, speed, radius, first, last)){
+                return false;
+            }
+            //一番遅く重なり始める軸が当たった面
+            if(first > preFirst){
+                float side = dist + speed * first;
+                hitAxis = axis * (side < 0.0f ? -1.0f : 1.0f);
+            }
+        }
+        t = first;
+        depth = 0.0f;
+        if(first == 0.0f){
+            //最初から重なっているときは一番浅い軸
+            return SupCubeCubeSAT(cube1, cube2, normal, depth);
+        }
+        normal = Normalize(ToWorldDirection(cube1, hitAxis));
+        return true;
+    }
+    
     //-----------------------------------------------------------------------------
     //  実装中（ここまで）
     //-----------------------------------------------------------------------------
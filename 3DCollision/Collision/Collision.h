@@ -43,6 +43,8 @@ namespace myTools {
     PlaneCollision CastToPlaneCollision(const Vector3& v1, const Vector3& v2, const Vector3& v3);
     PlaneCollision CastToPlaneCollision(const PolygonCollision& polygon);
     PlaneCollision CastToPlaneCollision(const SquareCollision& polygon);
+    //CubeCollision をちょうど包む AABB
+    AABBCollision CastToAABB(const CubeCollision& cube);
 
     bool IsFront(const PlaneCollision& plane, const Point& point);
     bool IsSharp(const Vector3& v1, const Vector3& v2, const Vector3& v3);
@@ -281,6 +283,49 @@ namespace myTools {
     //CubeAABBCollision and CubeAABBCollision
     bool CollisionReturnFlag(const AABBCollision& cub1, const AABBCollision& cube2);
     
+    //CubeCollision (OBB : direct are unit axes, scale is the half size along each axis)
+    //CubeCollision and Point
+    bool CollisionReturnFlag(const CubeCollision& cube, const Point& point);
+    bool CollisionReturnFlag(const Point& point, const CubeCollision& cube);
+    //cube の中(表面含む)で point に一番近い点
+    Point SupClosestPointCube(const CubeCollision& cube, const Point& point);
+    
+    //CubeCollision and SphereCollision
+    bool CollisionReturnFlag(const CubeCollision& cube, const SphereCollision& sphere);
+    bool CollisionReturnFlag(const SphereCollision& sphere, const CubeCollision& cube);
+    
+    //CubeCollision and CapsuleCollision
+    bool CollisionReturnFlag(const CubeCollision& cube, const CapsuleCollision& capsule);
+    bool CollisionReturnFlag(const CapsuleCollision& capsule, const CubeCollision& cube);
+    
+    //CubeCollision and CubeCollision
+    bool CollisionReturnFlag(const CubeCollision& cube1, const CubeCollision& cube2);
+    
+    /**
+     *  @tips   Separating axis test that also finds the axis with the least overlap.
+     *          normal points from cube1 to cube2, depth is the overlap along it.
+     *          An edge x edge axis is taken only when it is clearly shallower than the face axes.
+     *          Returns false (normal / depth not set) when they are apart.
+     */
+    bool SupCubeCubeSAT(const CubeCollision& cube1, const CubeCollision& cube2, Vector3& normal, float& depth);
+    
+    /**
+     *  @tips   cube2 moves by vel (t = 0 to 1) against cube1. t is the first time they touch
+     *          and normal points from cube1 to cube2 at that time.
+     *          When they already overlap t is 0 and normal / depth are the same as SupCubeCubeSAT
+     *          (depth is 0 otherwise).
+     */
+    bool SupCubeCubeSweep(const CubeCollision& cube1, const CubeCollision& cube2, const Vector3& vel,
+                          float& t, Vector3& normal, float& depth);
+    
+    /**
+     *  @tips   One separating axis of a moving pair. center is the distance between the two
+     *          along the axis, speed how fast it changes and radius the sum of their half widths.
+     *          Narrows [first, last] to the times when |center + speed * t| <= radius.
+     *          Returns false when they never overlap in [first, last].
+     */
+    bool SupAxisOverlapTime(float center, float speed, float radius, float& first, float& last);
+    
 }// namespace myTools
 
 #endif /* Collision_h */
@@ -0,0 +1,668 @@
+//
+//  ConvexCollision.cpp
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/02/07.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#include "ConvexCollision.h"
+#include <math.h>
+
+namespace myTools {
+
+    namespace {
+        const int GjkMaxIterations = 32;
+        //|v|^2 がこれより小さければ原点を含むとみなす
+        const float GjkEpsilonSq = 1.0e-10f;
+        //v がこれ以上原点に近づかなければ打ち切る(|v|^2 に対する割合)
+        const float GjkRelEpsilon = 1.0e-6f;
+
+        const int EpaMaxIterations = 64;
+        const int EpaMaxVertices = EpaMaxIterations + 4;
+        const int EpaMaxFaces = 128;
+        const int EpaMaxEdges = 64;
+        const float EpaTolerance = 1.0e-4f;
+        const float EpaPlaneEpsilon = 1.0e-5f;
+
+        const int CastMaxIterations = 32;
+        const float CastTolerance = 1.0e-3f;
+
+        //ミンコフスキー差の点と, それを作ったそれぞれの点
+        struct SimplexVertex {
+            Vector3 w;
+            Vector3 a;
+            Vector3 b;
+        };
+
+        struct Simplex {
+            SimplexVertex v[4];
+            float lambda[4] = {};
+            int count = 0;
+        };
+
+        SimplexVertex MakeVertex(const ConvexShape& lhs, const ConvexShape& rhs, const Vector3& dir){
+            SimplexVertex vertex;
+            vertex.a = lhs.Support(dir);
+            vertex.b = rhs.Support(-dir);
+            vertex.w = vertex.a - vertex.b;
+            return vertex;
+        }
+
+        //radius まで含めた形状のサポート点(EPA 用)
+        SimplexVertex MakeRoundVertex(const ConvexShape& lhs, const ConvexShape& rhs, const Vector3& dir){
+            SimplexVertex vertex = MakeVertex(lhs, rhs, dir);
+            float lengthSq = dir.LengthSq();
+            if(lengthSq > 0.0f && (lhs.radius > 0.0f || rhs.radius > 0.0f)){
+                Vector3 n = dir * (1.0f / sqrtf(lengthSq));
+                vertex.a += n * lhs.radius;
+                vertex.b -= n * rhs.radius;
+                vertex.w = vertex.a - vertex.b;
+            }
+            return vertex;
+        }
+
+        void Keep(Simplex& simplex, int i0, float l0){
+            simplex.v[0] = simplex.v[i0];
+            simplex.lambda[0] = l0;
+            simplex.count = 1;
+        }
+        void Keep(Simplex& simplex, int i0, int i1, float l0, float l1){
+            SimplexVertex v1 = simplex.v[i1];
+            simplex.v[0] = simplex.v[i0];
+            simplex.v[1] = v1;
+            simplex.lambda[0] = l0;
+            simplex.lambda[1] = l1;
+            simplex.count = 2;
+        }
+
+        //線分の中で原点に一番近い点
+        void SolveSegment(Simplex& simplex){
+            Vector3 a = simplex.v[0].w;
+            Vector3 ab = simplex.v[1].w - a;
+            float lengthSq = ab.LengthSq();
+            float t = lengthSq > 0.0f ? dot(-a, ab) / lengthSq : 0.0f;
+            if(t <= 0.0f){
+                Keep(simplex, 0, 1.0f);
+            }
+            else if(t >= 1.0f){
+                Keep(simplex, 1, 1.0f);
+            }
+            else {
+                simplex.lambda[0] = 1.0f - t;
+                simplex.lambda[1] = t;
+            }
+        }
+
+        //三角形の中で原点に一番近い点(Ericson の領域分け)
+        void SolveTriangle(Simplex& simplex){
+            Vector3 a = simplex.v[0].w;
+            Vector3 b = simplex.v[1].w;
+            Vector3 c = simplex.v[2].w;
+            Vector3 ab = b - a;
+            Vector3 ac = c - a;
+
+            float d1 = dot(ab, -a);
+            float d2 = dot(ac, -a);
+            if(d1 <= 0.0f && d2 <= 0.0f){
+                Keep(simplex, 0, 1.0f);
+                return;
+            }
+            float d3 = dot(ab, -b);
+            float d4 = dot(ac, -b);
+            if(d3 >= 0.0f && d4 <= d3){
+                Keep(simplex, 1, 1.0f);
+                return;
+            }
+            float vc = d1 * d4 - d3 * d2;
+            if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f){
+                float t = d1 / (d1 - d3);
+                Keep(simplex, 0, 1, 1.0f - t, t);
+                return;
+            }
+            float d5 = dot(ab, -c);
+            float d6 = dot(ac, -c);
+            if(d6 >= 0.0f && d5 <= d6){
+                Keep(simplex, 2, 1.0f);
+                return;
+            }
+            float vb = d5 * d2 - d1 * d6;
+            if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f){
+                float t = d2 / (d2 - d6);
+                Keep(simplex, 0, 2, 1.0f - t, t);
+                return;
+            }
+            float va = d3 * d6 - d5 * d4;
+            if(va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f){
+                float t = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+                Keep(simplex, 1, 2, 1.0f - t, t);
+                return;
+            }
+            float denom = va + vb + vc;
+            if(denom <= 0.0f){
+                //潰れた三角形は辺で解く
+                simplex.count = 2;
+                SolveSegment(simplex);
+                return;
+            }
+            denom = 1.0f / denom;
+            simplex.lambda[1] = vb * denom;
+            simplex.lambda[2] = vc * denom;
+            simplex.lambda[0] = 1.0f - simplex.lambda[1] - simplex.lambda[2];
+        }
+
+        //四面体の中で原点に一番近い点. 原点を含むときは count が 4 のまま
+        void SolveTetrahedron(Simplex& simplex){
+            static const int faces[4][4] = {
+                {0, 1, 2, 3},
+                {0, 2, 3, 1},
+                {0, 3, 1, 2},
+                {1, 3, 2, 0},
+            };
+            //潰れた四面体(箱同士の向きが揃っているとよくある)は面の表裏が誤差で決まるので全部の面を調べる
+            float lengthSq = 0.0f;
+            for(int i = 1; i < 4; ++i){
+                lengthSq = fmaxf(lengthSq, (simplex.v[i].w - simplex.v[0].w).LengthSq());
+            }
+            float volume = fabsf(dot(simplex.v[3].w - simplex.v[0].w,
+                                     cross(simplex.v[1].w - simplex.v[0].w, simplex.v[2].w - simplex.v[0].w)));
+            bool isFlat = volume <= GjkRelEpsilon * lengthSq * sqrtf(lengthSq);
+            Simplex best;
+            float bestDistSq = -1.0f;
+            for(int i = 0; i < 4; ++i){
+                const int* face = faces[i];
+                Vector3 a = simplex.v[face[0]].w;
+                Vector3 n = cross(simplex.v[face[1]].w - a, simplex.v[face[2]].w - a);
+                float side = dot(simplex.v[face[3]].w - a, n);
+                float origin = dot(-a, n);
+                //原点が面の外側(4つめの点と反対側)にあるときだけ調べる
+                if(!isFlat && side * origin > 0.0f){
+                    continue;
+                }
+                Simplex sub;
+                sub.v[0] = simplex.v[face[0]];
+                sub.v[1] = simplex.v[face[1]];
+                sub.v[2] = simplex.v[face[2]];
+                sub.count = 3;
+                SolveTriangle(sub);
+                Vector3 closest;
+                for(int j = 0; j < sub.count; ++j){
+                    closest += sub.v[j].w * sub.lambda[j];
+                }
+                float distSq = closest.LengthSq();
+                if(bestDistSq < 0.0f || distSq < bestDistSq){
+                    bestDistSq = distSq;
+                    best = sub;
+                }
+            }
+            if(bestDistSq < 0.0f){
+                //どの面の外側でもないので含む
+                return;
+            }
+            simplex = best;
+        }
+
+        Vector3 Solve(Simplex& simplex){
+            switch(simplex.count){
+                case 1:
+                    simplex.lambda[0] = 1.0f;
+                    break;
+                case 2:
+                    SolveSegment(simplex);
+                    break;
+                case 3:
+                    SolveTriangle(simplex);
+                    break;
+                default:
+                    SolveTetrahedron(simplex);
+                    if(simplex.count == 4){
+                        return Vector3();
+                    }
+                    break;
+            }
+            Vector3 v;
+            for(int i = 0; i < simplex.count; ++i){
+                v += simplex.v[i].w * simplex.lambda[i];
+            }
+            return v;
+        }
+
+        //芯同士の GJK. 芯が重なっていれば true
+        bool Gjk(const ConvexShape& lhs, const ConvexShape& rhs, Simplex& simplex, Vector3& v){
+            simplex.v[0] = MakeVertex(lhs, rhs, Vector3(1.0f, 0.0f, 0.0f));
+            simplex.lambda[0] = 1.0f;
+            simplex.count = 1;
+            v = simplex.v[0].w;
+            for(int iteration = 0; iteration < GjkMaxIterations; ++iteration){
+                float vv = v.LengthSq();
+                if(vv < GjkEpsilonSq){
+                    return true;
+                }
+                SimplexVertex vertex = MakeVertex(lhs, rhs, -v);
+                //これ以上原点に近づかない
+                if(vv - dot(v, vertex.w) <= GjkRelEpsilon * vv){
+                    return false;
+                }
+                for(int i = 0; i < simplex.count; ++i){
+                    if((simplex.v[i].w - vertex.w).LengthSq() < GjkEpsilonSq){
+                        return false;
+                    }
+                }
+                //v と合うように, 遠ざかったときは1つ前の単体に戻す
+                Simplex previous = simplex;
+                simplex.v[simplex.count++] = vertex;
+                Vector3 next = Solve(simplex);
+                if(simplex.count == 4){
+                    v = Vector3();
+                    return true;
+                }
+                //誤差で遠ざかったときは1つ前で止める
+                if(next.LengthSq() >= vv){
+                    simplex = previous;
+                    return false;
+                }
+                v = next;
+            }
+            return false;
+        }
+
+        void SetSeparated(const ConvexShape& lhs, const ConvexShape& rhs, const Simplex& simplex,
+                          const Vector3& v, ConvexHitData& data){
+            Vector3 a, b;
+            for(int i = 0; i < simplex.count; ++i){
+                a += simplex.v[i].a * simplex.lambda[i];
+                b += simplex.v[i].b * simplex.lambda[i];
+            }
+            float distance = v.Length();
+            data.normal = -v * (1.0f / distance);
+            data.distance = distance - lhs.radius - rhs.radius;
+            data.hit = data.distance <= 0.0f;
+            data.lhsPos = a + data.normal * lhs.radius;
+            data.rhsPos = b - data.normal * rhs.radius;
+        }
+
+        //三角形の中での重心座標
+        void Barycentric(const Vector3& p, const Vector3& a, const Vector3& b, const Vector3& c,
+                         float& u, float& v, float& w){
+            Vector3 v0 = b - a;
+            Vector3 v1 = c - a;
+            Vector3 v2 = p - a;
+            float d00 = dot(v0, v0);
+            float d01 = dot(v0, v1);
+            float d11 = dot(v1, v1);
+            float d20 = dot(v2, v0);
+            float d21 = dot(v2, v1);
+            float denom = d00 * d11 - d01 * d01;
+            if(fabsf(denom) < MT_EPSILON * MT_EPSILON){
+                u = 1.0f;
+                v = w = 0.0f;
+                return;
+            }
+            v = (d11 * d20 - d01 * d21) / denom;
+            w = (d00 * d21 - d01 * d20) / denom;
+            u = 1.0f - v - w;
+        }
+
+        struct EpaFace {
+            int index[3];
+            Vector3 normal;
+            float distance;
+        };
+
+        struct Polytope {
+            SimplexVertex vertices[EpaMaxVertices];
+            int vertexCount = 0;
+            EpaFace faces[EpaMaxFaces];
+            int faceCount = 0;
+            //最初の四面体の重心. 面の表を決めるのに使う
+            Vector3 center;
+
+            bool AddFace(int i0, int i1, int i2){
+                if(faceCount >= EpaMaxFaces){
+                    return false;
+                }
+                const Vector3& a = vertices[i0].w;
+                Vector3 n = cross(vertices[i1].w - a, vertices[i2].w - a);
+                float length = n.Length();
+                if(length < MT_EPSILON * MT_EPSILON){
+                    //潰れた面は作らない(隣の面が覆う)
+                    return true;
+                }
+                n *= 1.0f / length;
+                EpaFace& face = faces[faceCount++];
+                face.index[0] = i0;
+                if(dot(n, a - center) < 0.0f){
+                    n = -n;
+                    face.index[1] = i2;
+                    face.index[2] = i1;
+                }
+                else {
+                    face.index[1] = i1;
+                    face.index[2] = i2;
+                }
+                face.normal = n;
+                face.distance = dot(n, a);
+                return true;
+            }
+        };
+
+        //芯の単体を, 原点を含む(丸みまで入れた形状の)四面体へ広げる
+        bool BuildTetrahedron(const ConvexShape& lhs, const ConvexShape& rhs, const Simplex& simplex, Polytope& polytope){
+            static const Vector3 axes[6] = {
+                Vector3( 1.0f, 0.0f, 0.0f), Vector3(-1.0f, 0.0f, 0.0f),
+                Vector3( 0.0f, 1.0f, 0.0f), Vector3( 0.0f,-1.0f, 0.0f),
+                Vector3( 0.0f, 0.0f, 1.0f), Vector3( 0.0f, 0.0f,-1.0f),
+            };
+            SimplexVertex* v = polytope.vertices;
+            int count = simplex.count;
+            for(int i = 0; i < count; ++i){
+                v[i] = simplex.v[i];
+            }
+            if(count == 1){
+                for(int i = 0; i < 6 && count == 1; ++i){
+                    SimplexVertex vertex = MakeRoundVertex(lhs, rhs, axes[i]);
+                    if((vertex.w - v[0].w).LengthSq() > MT_EPSILON){
+                        v[count++] = vertex;
+                    }
+                }
+            }
+            if(count == 2){
+                Vector3 d = v[1].w - v[0].w;
+                for(int i = 0; i < 6 && count == 2; ++i){
+                    Vector3 n = cross(d, axes[i]);
+                    if(n.LengthSq() < MT_EPSILON){
+                        continue;
+                    }
+                    SimplexVertex vertex = MakeRoundVertex(lhs, rhs, n);
+                    if(cross(vertex.w - v[0].w, d).LengthSq() > MT_EPSILON * d.LengthSq()){
+                        v[count++] = vertex;
+                    }
+                }
+            }
+            if(count == 3){
+                Vector3 n = cross(v[1].w - v[0].w, v[2].w - v[0].w);
+                float lengthSq = n.LengthSq();
+                for(int i = 0; i < 2 && count == 3 && lengthSq > 0.0f; ++i){
+                    SimplexVertex vertex = MakeRoundVertex(lhs, rhs, i == 0 ? n : -n);
+                    float height = dot(vertex.w - v[0].w, n);
+                    if(height * height > MT_EPSILON * lengthSq){
+                        v[count++] = vertex;
+                    }
+                }
+            }
+            if(count < 4){
+                //厚みのない形状同士
+                return false;
+            }
+            polytope.vertexCount = 4;
+            polytope.center = (v[0].w + v[1].w + v[2].w + v[3].w) * 0.25f;
+            polytope.faceCount = 0;
+            polytope.AddFace(0, 1, 2);
+            polytope.AddFace(0, 3, 1);
+            polytope.AddFace(0, 2, 3);
+            polytope.AddFace(1, 3, 2);
+            return polytope.faceCount == 4;
+        }
+
+        //原点から一番近い面を外へ広げていく
+        bool Epa(const ConvexShape& lhs, const ConvexShape& rhs, const Simplex& simplex, ConvexHitData& data){
+            Polytope polytope;
+            if(!BuildTetrahedron(lhs, rhs, simplex, polytope)){
+                return false;
+            }
+            int closest = 0;
+            for(int iteration = 0; iteration < EpaMaxIterations; ++iteration){
+                closest = 0;
+                for(int i = 1; i < polytope.faceCount; ++i){
+                    if(polytope.faces[i].distance < polytope.faces[closest].distance){
+                        closest = i;
+                    }
+                }
+                EpaFace face = polytope.faces[closest];
+                SimplexVertex vertex = MakeRoundVertex(lhs, rhs, face.normal);
+                if(dot(vertex.w, face.normal) - face.distance < EpaTolerance ||
+                   polytope.vertexCount >= EpaMaxVertices){
+                    break;
+                }
+                int newIndex = polytope.vertexCount++;
+                polytope.vertices[newIndex] = vertex;
+
+                //新しい点から見える面を消し, 残った縁(horizon)と新しい点で面を張る
+                int edges[EpaMaxEdges][2];
+                int edgeCount = 0;
+                bool isOverflow = false;
+                for(int i = 0; i < polytope.faceCount;){
+                    const EpaFace& visible = polytope.faces[i];
+                    //同じ平面に乗る面も消す(残すと縁と新しい点が一直線になり面が潰れる)
+                    if(dot(visible.normal, vertex.w - polytope.vertices[visible.index[0]].w) <= -EpaPlaneEpsilon){
+                        ++i;
+                        continue;
+                    }
+                    for(int j = 0; j < 3; ++j){
+                        int e0 = visible.index[j];
+                        int e1 = visible.index[(j + 1) % 3];
+                        //隣の面でも消える辺は horizon ではない
+                        bool isShared = false;
+                        for(int k = 0; k < edgeCount; ++k){
+                            if(edges[k][0] == e1 && edges[k][1] == e0){
+                                edges[k][0] = edges[edgeCount - 1][0];
+                                edges[k][1] = edges[edgeCount - 1][1];
+                                --edgeCount;
+                                isShared = true;
+                                break;
+                            }
+                        }
+                        if(!isShared){
+                            if(edgeCount >= EpaMaxEdges){
+                                isOverflow = true;
+                                break;
+                            }
+                            edges[edgeCount][0] = e0;
+                            edges[edgeCount][1] = e1;
+                            ++edgeCount;
+                        }
+                    }
+                    polytope.faces[i] = polytope.faces[--polytope.faceCount];
+                }
+                for(int i = 0; i < edgeCount && !isOverflow; ++i){
+                    isOverflow = !polytope.AddFace(edges[i][0], edges[i][1], newIndex);
+                }
+                if(isOverflow || polytope.faceCount == 0){
+                    polytope.faces[0] = face;
+                    polytope.faceCount = 1;
+                    closest = 0;
+                    break;
+                }
+            }
+
+            const EpaFace& face = polytope.faces[closest];
+            const SimplexVertex& v0 = polytope.vertices[face.index[0]];
+            const SimplexVertex& v1 = polytope.vertices[face.index[1]];
+            const SimplexVertex& v2 = polytope.vertices[face.index[2]];
+            float u, v, w;
+            Barycentric(face.normal * face.distance, v0.w, v1.w, v2.w, u, v, w);
+            data.hit = true;
+            data.normal = face.normal;
+            data.distance = -face.distance;
+            data.lhsPos = v0.a * u + v1.a * v + v2.a * w;
+            data.rhsPos = v0.b * u + v1.b * v + v2.b * w;
+            return true;
+        }
+
+        Vector3 SupportPoint(const void* shape, const Vector3&){
+            return *static_cast<const Point*>(shape);
+        }
+        Vector3 SupportSegment(const void* shape, const Vector3& dir){
+            const Segment& segment = *static_cast<const Segment*>(shape);
+            return dot(segment.v, dir) > 0.0f ? segment.GetEndPoint() : segment.p;
+        }
+        template<int Count>
+        Vector3 SupportPoints(const Point (&points)[Count], const Vector3& dir){
+            int best = 0;
+            float bestDot = dot(points[0], dir);
+            for(int i = 1; i < Count; ++i){
+                float d = dot(points[i], dir);
+                if(d > bestDot){
+                    bestDot = d;
+                    best = i;
+                }
+            }
+            return points[best];
+        }
+        Vector3 SupportPolygon(const void* shape, const Vector3& dir){
+            return SupportPoints(static_cast<const PolygonCollision*>(shape)->p, dir);
+        }
+        Vector3 SupportSquare(const void* shape, const Vector3& dir){
+            return SupportPoints(static_cast<const SquareCollision*>(shape)->p, dir);
+        }
+        Vector3 SupportAABB(const void* shape, const Vector3& dir){
+            const AABBCollision& aabb = *static_cast<const AABBCollision*>(shape);
+            return Vector3(dir.x > 0.0f ? aabb.max.x : aabb.min.x,
+                           dir.y > 0.0f ? aabb.max.y : aabb.min.y,
+                           dir.z > 0.0f ? aabb.max.z : aabb.min.z);
+        }
+        Vector3 SupportCube(const void* shape, const Vector3& dir){
+            const CubeCollision& cube = *static_cast<const CubeCollision*>(shape);
+            Vector3 ret = cube.position;
+            for(int i = 0; i < 3; ++i){
+                float extent = cube.scale[i];
+                ret += cube.direct[i] * (dot(cube.direct[i], dir) > 0.0f ? extent : -extent);
+            }
+            return ret;
+        }
+        Vector3 SupportSphere(const void* shape, const Vector3&){
+            return static_cast<const SphereCollision*>(shape)->position;
+        }
+        Vector3 SupportDome(const void* shape, const Vector3&){
+            return static_cast<const DomeCollision*>(shape)->position;
+        }
+        Vector3 SupportCylinder(const void* shape, const Vector3& dir){
+            const CylinderCollision& cylinder = *static_cast<const CylinderCollision*>(shape);
+            const Line& axis = cylinder.line;
+            float along = dot(axis.v, dir);
+            Vector3 ret = along > 0.0f ? axis.p + axis.v : axis.p;
+            //軸に垂直な向きへ半径ぶん
+            float axisLengthSq = axis.v.LengthSq();
+            Vector3 side = dir;
+            if(axisLengthSq > 0.0f){
+                side -= axis.v * (along / axisLengthSq);
+                //dir が軸とほぼ平行だと桁落ちで軸向きの成分が残るのでもう一度引く
+                side -= axis.v * (dot(axis.v, side) / axisLengthSq);
+            }
+            float sideLengthSq = side.LengthSq();
+            if(sideLengthSq > MT_EPSILON * MT_EPSILON * dir.LengthSq()){
+                ret += side * (cylinder.radius / sqrtf(sideLengthSq));
+            }
+            return ret;
+        }
+        Vector3 SupportCapsule(const void* shape, const Vector3& dir){
+            return SupportSegment(&static_cast<const CapsuleCollision*>(shape)->s, dir);
+        }
+
+        ConvexShape MakeConvex(const void* shape, Vector3 (*support)(const void*, const Vector3&), float radius){
+            ConvexShape convex;
+            convex.shape = shape;
+            convex.support = support;
+            convex.radius = radius;
+            return convex;
+        }
+    }
+
+    ConvexShape CastToConvex(const Point& point){
+        return MakeConvex(&point, SupportPoint, 0.0f);
+    }
+    ConvexShape CastToConvex(const Segment& segment){
+        return MakeConvex(&segment, SupportSegment, 0.0f);
+    }
+    ConvexShape CastToConvex(const PolygonCollision& polygon){
+        return MakeConvex(&polygon, SupportPolygon, 0.0f);
+    }
+    ConvexShape CastToConvex(const SquareCollision& square){
+        return MakeConvex(&square, SupportSquare, 0.0f);
+    }
+    ConvexShape CastToConvex(const AABBCollision& aabb){
+        return MakeConvex(&aabb, SupportAABB, 0.0f);
+    }
+    ConvexShape CastToConvex(const CubeCollision& cube){
+        return MakeConvex(&cube, SupportCube, 0.0f);
+    }
+    ConvexShape CastToConvex(const SphereCollision& sphere){
+        return MakeConvex(&sphere, SupportSphere, sphere.radius);
+    }
+    ConvexShape CastToConvex(const DomeCollision& dome){
+        return MakeConvex(&dome, SupportDome, dome.maxRadius);
+    }
+    ConvexShape CastToConvex(const CylinderCollision& cylinder){
+        return MakeConvex(&cylinder, SupportCylinder, 0.0f);
+    }
+    ConvexShape CastToConvex(const CapsuleCollision& capsule){
+        return MakeConvex(&capsule, SupportCapsule, capsule.radius);
+    }
+
+    ConvexHitData ConvexDistance(const ConvexShape& lhs, const ConvexShape& rhs){
+        ConvexHitData data;
+        Simplex simplex;
+        Vector3 v;
+        if(Gjk(lhs, rhs, simplex, v)){
+            data.hit = true;
+            return data;
+        }
+        SetSeparated(lhs, rhs, simplex, v, data);
+        return data;
+    }
+
+    ConvexHitData ConvexCollision(const ConvexShape& lhs, const ConvexShape& rhs){
+        ConvexHitData data;
+        Simplex simplex;
+        Vector3 v;
+        if(!Gjk(lhs, rhs, simplex, v)){
+            //芯が離れていれば丸みを引くだけ
+            SetSeparated(lhs, rhs, simplex, v, data);
+            return data;
+        }
+        if(!Epa(lhs, rhs, simplex, data)){
+            //厚みのない形状同士は深さ 0 とする
+            data.hit = true;
+            data.distance = 0.0f;
+            data.normal = Vector3(0.0f, 1.0f, 0.0f);
+            data.lhsPos = data.rhsPos = simplex.v[0].a;
+        }
+        return data;
+    }
+
+    bool ConvexCast(const ConvexShape& lhs, const Vector3& lhsVel, const ConvexShape& rhs,
+                    float& t, ConvexHitData& data){
+        ConvexShape moved = lhs;
+        t = 0.0f;
+        data = ConvexDistance(moved, rhs);
+        if(data.hit){
+            return true;
+        }
+        for(int iteration = 0; iteration < CastMaxIterations; ++iteration){
+            if(data.distance <= CastTolerance){
+                return true;
+            }
+            //離れている向きへの速さ. 近づいていなければ当たらない
+            float approach = dot(lhsVel, data.normal);
+            if(approach <= MT_EPSILON){
+                return false;
+            }
+            float next = t + data.distance / approach;
+            if(next > 1.0f){
+                return false;
+            }
+            moved.offset = lhs.offset + lhsVel * next;
+            ConvexHitData nextData = ConvexDistance(moved, rhs);
+            if(nextData.hit){
+                //誤差で入り込んだときは1つ前の向きを使う
+                data.distance = 0.0f;
+                data.lhsPos += lhsVel * (next - t);
+                t = next;
+                return true;
+            }
+            t = next;
+            data = nextData;
+        }
+        return data.distance <= CastTolerance;
+    }
+}// namespace myTools
@@ -0,0 +1,91 @@
+//
+//  ConvexCollision.h
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/02/07.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#ifndef ConvexCollision_h
+#define ConvexCollision_h
+
+#include "Primitive.h"
+
+namespace myTools {
+
+    /**
+     *  @tips   Convex shape described only by its support function (the farthest point along dir).
+     *          Spheres and capsules are kept as a core (point / segment) plus radius. The radius is
+     *          subtracted from the core distance, so shallow overlaps need no EPA.
+     *          shape only points to the original, so keep the original alive until the test is done
+     */
+    struct ConvexShape {
+        const void* shape = nullptr;
+        Vector3 (*support)(const void* shape, const Vector3& dir) = nullptr;
+        float radius = 0.0f;
+        //全体をずらす(移動中の判定に使う)
+        Vector3 offset;
+
+        //芯の上で dir の向きに一番遠い点
+        Vector3 Support(const Vector3& dir) const {
+            return support(shape, dir) + offset;
+        }
+    };
+
+    /**
+     *  @tips   Shapes that are not bounded (Line, PlaneCollision) have no support point.
+     *          DomeCollision is its outer ball (maxRadius); the hollow inside is not represented.
+     *          CubeCollision : direct are unit axes and scale is the half size along each axis.
+     */
+    ConvexShape CastToConvex(const Point& point);
+    ConvexShape CastToConvex(const Segment& segment);
+    ConvexShape CastToConvex(const PolygonCollision& polygon);
+    ConvexShape CastToConvex(const SquareCollision& square);
+    ConvexShape CastToConvex(const AABBCollision& aabb);
+    ConvexShape CastToConvex(const CubeCollision& cube);
+    ConvexShape CastToConvex(const SphereCollision& sphere);
+    ConvexShape CastToConvex(const DomeCollision& dome);
+    ConvexShape CastToConvex(const CylinderCollision& cylinder);
+    ConvexShape CastToConvex(const CapsuleCollision& capsule);
+
+    /**
+     *  @tips   Result of GJK / EPA. normal is a unit vector from lhs to rhs.
+     *          distance is between the surfaces and negative (the depth) when they overlap.
+     *          lhsPos / rhsPos are the closest points on each surface (the deepest points when overlapping)
+     */
+    struct ConvexHitData {
+        bool hit = false;
+        float distance = 0.0f;
+        Vector3 normal;
+        Vector3 lhsPos;
+        Vector3 rhsPos;
+    };
+
+    /**
+     *  @tips   Distance between lhs and rhs by GJK. When they overlap only hit is set
+     *          (distance 0, no normal). Cheaper than ConvexCollision when the depth is not needed.
+     */
+    ConvexHitData ConvexDistance(const ConvexShape& lhs, const ConvexShape& rhs);
+
+    /**
+     *  @tips   Distance by GJK, and the depth and normal by EPA when they overlap.
+     */
+    ConvexHitData ConvexCollision(const ConvexShape& lhs, const ConvexShape& rhs);
+
+    /**
+     *  @tips   Move lhs by lhsVel (t = 0 to 1) against rhs that does not move (conservative advancement).
+     *          Returns false when they do not touch by t = 1.
+     *          data is the contact at time t. Call only when they do not overlap at t = 0.
+     */
+    bool ConvexCast(const ConvexShape& lhs, const Vector3& lhsVel, const ConvexShape& rhs,
+                    float& t, ConvexHitData& data);
+
+    //どの組み合わせでも使える版
+    template<typename Ty1, typename Ty2>
+    ConvexHitData ConvexCollision(const Ty1& lhs, const Ty2& rhs){
+        return ConvexCollision(CastToConvex(lhs), CastToConvex(rhs));
+    }
+
+}// namespace myTools
+
+#endif /* ConvexCollision_h */
@@ -61,19 +61,42 @@ namespace myTools {
             Segment(p[2], p[3] - p[2]),
             Segment(p[3], p[0] - p[3])};
     }
+    void SquareCollision::GetSides(Segment (&sides)[4]) const{
+        sides[0] = Segment(p[0], p[1] - p[0]);
+        sides[1] = Segment(p[1], p[2] - p[1]);
+        sides[2] = Segment(p[2], p[3] - p[2]);
+        sides[3] = Segment(p[3], p[0] - p[3]);
+    }
     
     std::vector<Point> AABBCollision::GetPoints() const{
-        std::vector<Point> ret;
-        ret.push_back(Vector3(min.x,max.y, max.z));
-        ret.push_back(Vector3(min.x,min.y, max.z));
-        ret.push_back(Vector3(max.x,min.y, max.z));
-        ret.push_back(max);
-        ret.push_back(Vector3(min.x,max.y,min.z));
-        ret.push_back(min);
-        ret.push_back(Vector3(max.x,min.y,min.z));
-        ret.push_back(Vector3(max.x,max.y,min.z));
+        std::vector<Point> ret(8);
+        Point points[8];
+        GetPoints(points);
+        for(int i = 0; i < 8; ++i){
+            ret[i] = points[i];
+        }
         return ret;
     }
+    void AABBCollision::GetPoints(Point (&points)[8]) const{
+        points[0] = Vector3(min.x,max.y, max.z);
+        points[1] = Vector3(min.x,min.y, max.z);
+        points[2] = Vector3(max.x,min.y, max.z);
+        points[3] = max;
+        points[4] = Vector3(min.x,max.y,min.z);
+        points[5] = min;
+        points[6] = Vector3(max.x,min.y,min.z);
+        points[7] = Vector3(max.x,max.y,min.z);
+    }
+    void AABBCollision::GetSquares(SquareCollision (&squares)[6]) const{
+        Point verts[8];
+        GetPoints(verts);
+        squares[0] = SquareCollision(verts[0], verts[1], verts[2], verts[3],false);
+        squares[1] = SquareCollision(verts[3], verts[2], verts[6], verts[7],false);
+        squares[2] = SquareCollision(verts[7], verts[6], verts[5], verts[4],false);
+        squares[3] = SquareCollision(verts[4], verts[5], verts[1], verts[0],false);
+        squares[4] = SquareCollision(verts[4], verts[0], verts[3], verts[7],false);
+        squares[5] = SquareCollision(verts[1], verts[5], verts[6], verts[2],false);
+    }
     
     Vector3 CapsuleCollision::ToHitPos(const Vector3 hitPos, const Vector3 position) {
         Vector3 onLine = CastToLine(Line(position, s.v), hitPos);
@@ -78,6 +78,8 @@ namespace myTools {
         Vector3 GetNormal() const;
         std::vector<Point> GetPoints() const;
         std::vector<Segment> GetSides() const;
+        //確保なし版
+        void GetSides(Segment (&sides)[4]) const;
     private:
         bool isCulculated = false;
         Vector3 normal;
@@ -88,6 +90,12 @@ namespace myTools {
         Vector3 max;
         Vector3 min;
         std::vector<Point> GetPoints() const ;
+        //確保なし版. 頂点の並びはvector版と同じ
+        void GetPoints(Point (&points)[8]) const;
+        /**
+         *  @tips   6 faces built from GetPoints. Normals are not culculated (call CulcNormal if needed)
+         */
+        void GetSquares(SquareCollision (&squares)[6]) const;
     };
     
     struct CubeCollision {
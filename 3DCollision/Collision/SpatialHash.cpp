@@ -0,0 +1,167 @@
+//
+//  SpatialHash.cpp
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/24.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#include "SpatialHash.h"
+#include <math.h>
+#include <algorithm>
+
+namespace myTools {
+
+    namespace {
+        bool IsOverlapAABB(const AABBCollision& a, const AABBCollision& b){
+            return !(a.max.x < b.min.x || a.min.x > b.max.x ||
+                     a.max.y < b.min.y || a.min.y > b.max.y ||
+                     a.max.z < b.min.z || a.min.z > b.max.z);
+        }
+    }
+
+    SpatialHash::SpatialHash(float cellSize) : cellSize(cellSize){
+    }
+
+    void SpatialHash::Clear(){
+        objects.clear();
+        largeObjects.clear();
+    }
+
+    int SpatialHash::ToCell(float value) const {
+        //とても遠い座標でも int があふれないようにする
+        const float cellLimit = 1.0e9f;
+        return (int)fmaxf(-cellLimit, fminf(floorf(value / cellSize), cellLimit));
+    }
+
+    unsigned int SpatialHash::Hash(int x, int y, int z) const {
+        return (((unsigned int)x * 73856093u) ^ ((unsigned int)y * 19349663u) ^ ((unsigned int)z * 83492791u)) & bucketMask;
+    }
+
+    void SpatialHash::Insert(const AABBCollision& aabb, int userData){
+        Object object;
+        object.aabb = aabb;
+        object.userData = userData;
+        for(int axis = 0; axis < 3; ++axis){
+            object.minCell[axis] = ToCell(aabb.min[axis]);
+            object.maxCell[axis] = ToCell(aabb.max[axis]);
+        }
+        //セルの数は int に収まらないこともあるので 64bit で数える
+        long long cellCount = 1;
+        for(int axis = 0; axis < 3 && cellCount <= maxObjectCells; ++axis){
+            cellCount *= (long long)object.maxCell[axis] - object.minCell[axis] + 1;
+        }
+        object.isLarge = cellCount > maxObjectCells;
+        if(object.isLarge){
+            largeObjects.push_back((int)objects.size());
+        }
+        objects.push_back(object);
+    }
+
+    //数え上げソートでバケットごとにセルを詰める. 全部線形時間
+    void SpatialHash::Build(){
+        int entryCount = 0;
+        for(auto& object : objects){
+            if(object.isLarge){
+                continue;
+            }
+            entryCount += (object.maxCell[0] - object.minCell[0] + 1) *
+            (object.maxCell[1] - object.minCell[1] + 1) *
+            (object.maxCell[2] - object.minCell[2] + 1);
+        }
+        unsigned int bucketCount = 16;
+        while(bucketCount < (unsigned int)entryCount * 2){
+            bucketCount <<= 1;
+        }
+        bucketMask = bucketCount - 1;
+
+        bucketStart.assign(bucketCount + 1, 0);
+        for(auto& object : objects){
+            if(object.isLarge){
+                continue;
+            }
+            for(int x = object.minCell[0]; x <= object.maxCell[0]; ++x){
+                for(int y = object.minCell[1]; y <= object.maxCell[1]; ++y){
+                    for(int z = object.minCell[2]; z <= object.maxCell[2]; ++z){
+                        ++bucketStart[Hash(x, y, z) + 1];
+                    }
+                }
+            }
+        }
+        for(unsigned int i = 0; i < bucketCount; ++i){
+            bucketStart[i + 1] += bucketStart[i];
+        }
+
+        entries.resize(entryCount);
+        bucketCursor.assign(bucketStart.begin(), bucketStart.end() - 1);
+        for(int i = 0; i < (int)objects.size(); ++i){
+            const Object& object = objects[i];
+            if(object.isLarge){
+                continue;
+            }
+            for(int x = object.minCell[0]; x <= object.maxCell[0]; ++x){
+                for(int y = object.minCell[1]; y <= object.maxCell[1]; ++y){
+                    for(int z = object.minCell[2]; z <= object.maxCell[2]; ++z){
+                        Entry& entry = entries[bucketCursor[Hash(x, y, z)]++];
+                        entry.object = i;
+                        entry.cell[0] = x;
+                        entry.cell[1] = y;
+                        entry.cell[2] = z;
+                    }
+                }
+            }
+        }
+    }
+
+    void SpatialHash::QueryPairs(std::vector<std::pair<int,int>>& pairs){
+        pairs.clear();
+        Build();
+        int bucketCount = (int)bucketStart.size() - 1;
+        for(int bucket = 0; bucket < bucketCount; ++bucket){
+            int begin = bucketStart[bucket];
+            int end = bucketStart[bucket + 1];
+            for(int i = begin; i < end; ++i){
+                const Entry& lhs = entries[i];
+                const Object& a = objects[lhs.object];
+                for(int j = i + 1; j < end; ++j){
+                    const Entry& rhs = entries[j];
+                    //ハッシュが衝突しただけの別のセルは飛ばす
+                    if(rhs.object == lhs.object ||
+                       rhs.cell[0] != lhs.cell[0] || rhs.cell[1] != lhs.cell[1] || rhs.cell[2] != lhs.cell[2]){
+                        continue;
+                    }
+                    const Object& b = objects[rhs.object];
+                    //複数のセルで重なっている場合は共有している一番小さいセルだけで報告する
+                    bool first = true;
+                    for(int axis = 0; axis < 3; ++axis){
+                        if(lhs.cell[axis] != std::max(a.minCell[axis], b.minCell[axis])){
+                            first = false;
+                            break;
+                        }
+                    }
+                    if(!first){
+                        continue;
+                    }
+                    if(!IsOverlapAABB(a.aabb, b.aabb)){
+                        continue;
+                    }
+                    pairs.emplace_back(a.userData, b.userData);
+                }
+            }
+        }
+        //大きい物体はハッシュに入っていないので全部の物体と調べる
+        for(int large : largeObjects){
+            const Object& a = objects[large];
+            for(int i = 0; i < (int)objects.size(); ++i){
+                const Object& b = objects[i];
+                //大きい物体どうしは1回だけ
+                if(i == large || (b.isLarge && i < large)){
+                    continue;
+                }
+                if(IsOverlapAABB(a.aabb, b.aabb)){
+                    pairs.emplace_back(a.userData, b.userData);
+                }
+            }
+        }
+    }
+}// namespace myTools
@@ -0,0 +1,91 @@
+//
+//  SpatialHash.h
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/24.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#ifndef SpatialHash_h
+#define SpatialHash_h
+
+#include "Primitive.h"
+#include <vector>
+#include <utility>
+
+namespace myTools {
+
+    /**
+     *  @tips   Uniform grid hash for the broad phase.
+     *          Integer cell coordinates are hashed into buckets, so the world is not bounded.
+     *          Rebuilt every frame with Clear -> Insert -> QueryPairs.
+     *          It is fastest when cellSize is about the size of the largest object.
+     *          Objects spanning more than maxObjectCells cells are not hashed and are tested against every object
+     */
+    class SpatialHash {
+    public:
+        static const int maxObjectCells = 64;
+
+        SpatialHash(float cellSize = 2.0f);
+
+        float GetCellSize() const {
+            return cellSize;
+        }
+        void SetCellSize(float cellSize){
+            this->cellSize = cellSize;
+        }
+
+        void Clear();
+
+        /**
+         *  @tips   aabb is inserted into every cell it touches
+         */
+        void Insert(const AABBCollision& aabb, int userData);
+
+        /**
+         *  @tips   Insert MoveCollData<Ty> by its swept aabb (call CulcAABB first)
+         */
+        template<typename Ty>
+        void Insert(const Ty& data, int userData){
+            Insert(data.aabb, userData);
+        }
+
+        /**
+         *  @tips   Collect every overlapping pair as (userData, userData). Each pair appears once.
+         */
+        void QueryPairs(std::vector<std::pair<int,int>>& pairs);
+
+        int GetObjectCount() const {
+            return (int)objects.size();
+        }
+
+    private:
+        struct Object {
+            AABBCollision aabb;
+            int userData;
+            int minCell[3];
+            int maxCell[3];
+            bool isLarge;
+        };
+        struct Entry {
+            int object;
+            int cell[3];
+        };
+
+        unsigned int Hash(int x, int y, int z) const;
+        int ToCell(float value) const;
+        void Build();
+
+        float cellSize;
+        std::vector<Object> objects;
+        //セルが多すぎてハッシュに入れない物体
+        std::vector<int> largeObjects;
+        //バケットごとに詰めたセル. bucketStart[i] ~ bucketStart[i + 1] がバケットi
+        std::vector<Entry> entries;
+        std::vector<int> bucketStart;
+        std::vector<int> bucketCursor;
+        unsigned int bucketMask = 0;
+    };
+}// namespace myTools
+
+#endif /* SpatialHash_h */
@@ -0,0 +1,182 @@
+//
+//  StaticBVH.cpp
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/25.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#include "StaticBVH.h"
+#include <algorithm>
+
+namespace myTools {
+
+    namespace {
+        const int binCount = 12;
+
+        struct Bin {
+            Vector3 min = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+            Vector3 max = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+            int count = 0;
+        };
+
+        void Grow(Vector3& min, Vector3& max, const Vector3& boxMin, const Vector3& boxMax){
+            min = Vector3(std::min(min.x, boxMin.x), std::min(min.y, boxMin.y), std::min(min.z, boxMin.z));
+            max = Vector3(std::max(max.x, boxMax.x), std::max(max.y, boxMax.y), std::max(max.z, boxMax.z));
+        }
+
+        float HalfArea(const Vector3& min, const Vector3& max){
+            Vector3 d = max - min;
+            return d.x * d.y + d.y * d.z + d.z * d.x;
+        }
+    }
+
+    void StaticBVH::Build(const AABBCollision* src, int count){
+        nodes.clear();
+        boxIndices.resize(count);
+        boxes.resize(count);
+        for(int i = 0; i < count; ++i){
+            boxIndices[i] = i;
+            boxes[i].min = src[i].min;
+            boxes[i].max = src[i].max;
+            boxes[i].center = (src[i].min + src[i].max) * 0.5f;
+        }
+        if(count == 0){
+            return;
+        }
+        //節は最大 2n - 1 個
+        nodes.reserve(count * 2);
+        nodes.push_back(Node());
+        nodes[0].first = 0;
+        nodes[0].count = count;
+        CulcBounds(nodes[0]);
+        Subdivide(0, 0);
+    }
+
+    void StaticBVH::CulcBounds(Node& node) const {
+        node.min = Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+        node.max = Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for(int i = node.first; i < node.first + node.count; ++i){
+            Grow(node.min, node.max, boxes[i].min, boxes[i].max);
+        }
+    }
+
+    int StaticBVH::Partition(int first, int count, int axis, float split){
+        int i = first;
+        int j = first + count - 1;
+        while(i <= j){
+            if(boxes[i].center[axis] < split){
+                ++i;
+            }
+            else {
+                std::swap(boxes[i], boxes[j]);
+                std::swap(boxIndices[i], boxIndices[j]);
+                --j;
+            }
+        }
+        return i - first;
+    }
+
+    void StaticBVH::Subdivide(int nodeId, int depth){
+        int first = nodes[nodeId].first;
+        int count = nodes[nodeId].count;
+        if(count <= maxLeafSize || depth >= maxDepth){
+            return;
+        }
+
+        //中心点の範囲で分割位置を決める
+        Vector3 centerMin(FLT_MAX, FLT_MAX, FLT_MAX);
+        Vector3 centerMax(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+        for(int i = first; i < first + count; ++i){
+            Grow(centerMin, centerMax, boxes[i].center, boxes[i].center);
+        }
+
+        float bestCost = FLT_MAX;
+        int bestAxis = -1;
+        float bestSplit = 0.0f;
+        for(int axis = 0; axis < 3; ++axis){
+            float extent = centerMax[axis] - centerMin[axis];
+            if(extent <= 0.0f){
+                continue;
+            }
+            Bin bins[binCount];
+            float scale = binCount / extent;
+            for(int i = first; i < first + count; ++i){
+                int b = std::min(binCount - 1, (int)((boxes[i].center[axis] - centerMin[axis]) * scale));
+                Grow(bins[b].min, bins[b].max, boxes[i].min, boxes[i].max);
+                ++bins[b].count;
+            }
+            //左から/右から累積した面積と数
+            float leftArea[binCount - 1];
+            float rightArea[binCount - 1];
+            int leftCount[binCount - 1];
+            int rightCount[binCount - 1];
+            Bin left;
+            Bin right;
+            for(int i = 0; i < binCount - 1; ++i){
+                left.count += bins[i].count;
+                Grow(left.min, left.max, bins[i].min, bins[i].max);
+                leftCount[i] = left.count;
+                leftArea[i] = left.count > 0 ? HalfArea(left.min, left.max) : 0.0f;
+
+                int r = binCount - 1 - i;
+                right.count += bins[r].count;
+                Grow(right.min, right.max, bins[r].min, bins[r].max);
+                rightCount[r - 1] = right.count;
+                rightArea[r - 1] = right.count > 0 ? HalfArea(right.min, right.max) : 0.0f;
+            }
+            for(int i = 0; i < binCount - 1; ++i){
+                if(leftCount[i] == 0 || rightCount[i] == 0){
+                    continue;
+                }
+                float cost = leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i];
+                if(cost < bestCost){
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = centerMin[axis] + (i + 1) / scale;
+                }
+            }
+        }
+
+        int leftCount;
+        if(bestAxis < 0){
+            //中心が全部同じ位置. 数で半分に分ける
+            leftCount = count / 2;
+        }
+        else {
+            //分けない方が安いなら葉のままにする
+            float leafCost = count * HalfArea(nodes[nodeId].min, nodes[nodeId].max);
+            if(bestCost >= leafCost && count <= maxLeafSize * 4){
+                return;
+            }
+            leftCount = Partition(first, count, bestAxis, bestSplit);
+            if(leftCount == 0 || leftCount == count){
+                leftCount = count / 2;
+            }
+        }
+
+        int leftId = (int)nodes.size();
+        nodes.push_back(Node());
+        nodes.push_back(Node());
+        nodes[leftId].first = first;
+        nodes[leftId].count = leftCount;
+        nodes[leftId + 1].first = first + leftCount;
+        nodes[leftId + 1].count = count - leftCount;
+        CulcBounds(nodes[leftId]);
+        CulcBounds(nodes[leftId + 1]);
+        nodes[nodeId].first = leftId;
+        nodes[nodeId].count = 0;
+
+        Subdivide(leftId, depth + 1);
+        Subdivide(leftId + 1, depth + 1);
+    }
+
+    void StaticBVH::Query(const AABBCollision& aabb, std::vector<int>& indices) const {
+        indices.clear();
+        Query(aabb, [&](int index){
+            indices.push_back(index);
+            return true;
+        });
+        std::sort(indices.begin(), indices.end());
+    }
+}// namespace myTools
@@ -0,0 +1,219 @@
+//
+//  StaticBVH.h
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/25.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#ifndef StaticBVH_h
+#define StaticBVH_h
+
+#include "Primitive.h"
+#include <math.h>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace myTools {
+
+    /**
+     *  @tips   BVH for static level geometry (an array of AABBCollision).
+     *          Built once with binned SAH, then only queried.
+     *          The array is not kept, so call Build again after changing it
+     */
+    class StaticBVH {
+    public:
+        static const int maxLeafSize = 4;
+        static const int maxDepth = 64;
+        //RayQuery で一度に辿るレイの数の上限(マスクのビット数)
+        static const int maxPacketSize = 32;
+
+        void Build(const AABBCollision* boxes, int count);
+        void Build(const std::vector<AABBCollision>& boxes){
+            Build(boxes.data(), (int)boxes.size());
+        }
+
+        /**
+         *  @tips   func(int index) is called for each box overlapping aabb. index is the position in the built array.
+         *          If func returns false, the query is stopped.
+         */
+        template<typename Func>
+        void Query(const AABBCollision& aabb, Func func) const;
+
+        /**
+         *  @tips   Indices of the boxes overlapping aabb in ascending order,
+         *          so the result can be processed in the same order as a linear loop over the array.
+         */
+        void Query(const AABBCollision& aabb, std::vector<int>& indices) const;
+
+        /**
+         *  @tips   Packet traversal for count (<= maxPacketSize) rays at once. Ray i is rays[i].p + rays[i].v * t
+         *          for t = 0 to tMax[i]. func(int index, unsigned int mask) is called for each box hit by
+         *          the rays in mask (bit i is ray i). func may shorten tMax[i] so farther nodes are skipped.
+         *          Nearer children are visited first along rays[0], so a packet should point the same way.
+         */
+        template<typename Func>
+        void RayQuery(const Segment* rays, int count, float* tMax, Func func) const;
+
+        int GetNodeCount() const {
+            return (int)nodes.size();
+        }
+        int GetBoxCount() const {
+            return (int)boxIndices.size();
+        }
+
+    private:
+        struct Node {
+            Vector3 min;
+            Vector3 max;
+            //葉なら最初の箱の位置(boxIndices), 節なら左の子. 右の子は必ず left + 1
+            int first;
+            //葉なら箱の数, 節なら0
+            int count;
+        };
+        struct BuildBox {
+            Vector3 min;
+            Vector3 max;
+            Vector3 center;
+        };
+
+        static bool Overlap(const Vector3& min, const Vector3& max, const AABBCollision& aabb){
+            return !(max.x < aabb.min.x || min.x > aabb.max.x ||
+                     max.y < aabb.min.y || min.y > aabb.max.y ||
+                     max.z < aabb.min.z || min.z > aabb.max.z);
+        }
+
+        //bits は 0 でないこと
+        static int LowestBit(unsigned int bits){
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, bits);
+            return (int)index;
+#else
+            return __builtin_ctz(bits);
+#endif
+        }
+        //レイ(1 / v を持つ)が t = 0 ～ tMax の間に箱を通るか
+        static bool RayOverlap(const Vector3& min, const Vector3& max, const Vector3& origin,
+                               const Vector3& invDir, float tMax){
+            float tNear = 0.0f;
+            float tFar = tMax;
+            for(int i = 0; i < 3; ++i){
+                float t1 = (min[i] - origin[i]) * invDir[i];
+                float t2 = (max[i] - origin[i]) * invDir[i];
+                tNear = fmaxf(tNear, fminf(t1, t2));
+                tFar = fminf(tFar, fmaxf(t1, t2));
+            }
+            return tNear <= tFar;
+        }
+
+        void Subdivide(int nodeId, int depth);
+        void CulcBounds(Node& node) const;
+        int Partition(int first, int count, int axis, float split);
+
+        std::vector<Node> nodes;
+        std::vector<int> boxIndices;
+        std::vector<BuildBox> boxes;
+    };
+
+    template<typename Func>
+    void StaticBVH::Query(const AABBCollision& aabb, Func func) const {
+        if(nodes.empty()){
+            return;
+        }
+        //深さはmaxDepthまでなので足りる
+        int stack[maxDepth * 2 + 2];
+        int top = 0;
+        stack[top++] = 0;
+        while(top > 0){
+            const Node& node = nodes[stack[--top]];
+            if(!Overlap(node.min, node.max, aabb)){
+                continue;
+            }
+            if(node.count > 0){
+                for(int i = node.first; i < node.first + node.count; ++i){
+                    const BuildBox& box = boxes[i];
+                    if(Overlap(box.min, box.max, aabb) && !func(boxIndices[i])){
+                        return;
+                    }
+                }
+            }
+            else {
+                stack[top++] = node.first;
+                stack[top++] = node.first + 1;
+            }
+        }
+    }
+
+    template<typename Func>
+    void StaticBVH::RayQuery(const Segment* rays, int count, float* tMax, Func func) const {
+        if(nodes.empty() || count <= 0){
+            return;
+        }
+        if(count > maxPacketSize){
+            count = maxPacketSize;
+        }
+        //軸に平行なレイは 1 / 0 の代わりに大きな値にする(0 * inf で NaN にならないように)
+        Vector3 invDirs[maxPacketSize];
+        for(int i = 0; i < count; ++i){
+            for(int j = 0; j < 3; ++j){
+                float v = rays[i].v[j];
+                invDirs[i][j] = v != 0.0f ? 1.0f / v : (signbit(v) ? -1.0e30f : 1.0e30f);
+            }
+        }
+        unsigned int allMask = count == maxPacketSize ? ~0u : (1u << count) - 1u;
+
+        //節ごとにその節まで届いているレイのマスクも積む
+        struct Entry {
+            int node;
+            unsigned int mask;
+        };
+        Entry stack[maxDepth * 2 + 2];
+        int top = 0;
+        stack[top++] = {0, allMask};
+        while(top > 0){
+            Entry entry = stack[--top];
+            const Node& node = nodes[entry.node];
+            unsigned int mask = 0;
+            for(unsigned int bits = entry.mask; bits; bits &= bits - 1){
+                int i = LowestBit(bits);
+                if(RayOverlap(node.min, node.max, rays[i].p, invDirs[i], tMax[i])){
+                    mask |= 1u << i;
+                }
+            }
+            if(mask == 0){
+                continue;
+            }
+            if(node.count > 0){
+                for(int j = node.first; j < node.first + node.count; ++j){
+                    const BuildBox& box = boxes[j];
+                    unsigned int boxMask = 0;
+                    for(unsigned int bits = mask; bits; bits &= bits - 1){
+                        int i = LowestBit(bits);
+                        if(RayOverlap(box.min, box.max, rays[i].p, invDirs[i], tMax[i])){
+                            boxMask |= 1u << i;
+                        }
+                    }
+                    if(boxMask){
+                        func(boxIndices[j], boxMask);
+                    }
+                }
+            }
+            else {
+                //近い子を後に積んで先に辿る
+                const Node& left = nodes[node.first];
+                const Node& right = nodes[node.first + 1];
+                const Vector3& dir = rays[0].v;
+                bool isLeftNear = dot(left.min + left.max, dir) <= dot(right.min + right.max, dir);
+                int near = isLeftNear ? node.first : node.first + 1;
+                int far = isLeftNear ? node.first + 1 : node.first;
+                stack[top++] = {far, mask};
+                stack[top++] = {near, mask};
+            }
+        }
+    }
+}// namespace myTools
+
+#endif /* StaticBVH_h */
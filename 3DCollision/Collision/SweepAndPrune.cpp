@@ -0,0 +1,196 @@
+//
+//  SweepAndPrune.cpp
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/23.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#include "SweepAndPrune.h"
+
+namespace myTools {
+
+    //同じ値のときはminを先に並べる(接しているだけでも重なりとみなす)
+    static bool Less(float lhsValue, bool lhsIsMax, float rhsValue, bool rhsIsMax){
+        if(lhsValue < rhsValue){
+            return true;
+        }
+        return lhsValue == rhsValue && !lhsIsMax && rhsIsMax;
+    }
+
+    int SweepAndPrune::AddProxy(const AABBCollision& aabb, int userData){
+        int proxyId;
+        if(freeProxies.empty()){
+            proxyId = (int)proxies.size();
+            proxies.push_back(Proxy());
+        }
+        else {
+            proxyId = freeProxies.back();
+            freeProxies.pop_back();
+            proxies[proxyId] = Proxy();
+        }
+        Proxy& proxy = proxies[proxyId];
+        proxy.aabb = aabb;
+        proxy.userData = userData;
+
+        //一番後ろ(無限遠)から入ってくるものとして扱う. 並べ直しとペアの追加はUpdateで行う
+        for(int axis = 0; axis < 3; ++axis){
+            std::vector<EndPoint>& endPoints = axes[axis];
+            endPoints.push_back({aabb.min[axis], (uint32_t)proxyId << 1});
+            endPoints.push_back({aabb.max[axis], ((uint32_t)proxyId << 1) | 1});
+            SetEndPointIndex(axis, (int)endPoints.size() - 2);
+            SetEndPointIndex(axis, (int)endPoints.size() - 1);
+        }
+        return proxyId;
+    }
+
+    void SweepAndPrune::RemoveProxy(int proxyId){
+        //無限遠に飛ばしておけばUpdateで後ろに集まり、途中で追い越したペアは外れる
+        Vector3 far(FLT_MAX, FLT_MAX, FLT_MAX);
+        AABBCollision aabb;
+        aabb.min = aabb.max = far;
+        UpdateProxy(proxyId, aabb);
+        pendingFreeProxies.push_back(proxyId);
+    }
+
+    void SweepAndPrune::UpdateProxy(int proxyId, const AABBCollision& aabb){
+        Proxy& proxy = proxies[proxyId];
+        proxy.aabb = aabb;
+        for(int axis = 0; axis < 3; ++axis){
+            axes[axis][proxy.minIndex[axis]].value = aabb.min[axis];
+            axes[axis][proxy.maxIndex[axis]].value = aabb.max[axis];
+        }
+    }
+
+    void SweepAndPrune::Update(){
+        //前のフレームからほぼ並んでいるので挿入ソートでほぼO(n)
+        for(int axis = 0; axis < 3; ++axis){
+            int size = (int)axes[axis].size();
+            for(int i = 1; i < size; ++i){
+                SortDown(axis, i);
+            }
+            //消したproxyの端点は末尾に集まっている
+            axes[axis].resize(axes[axis].size() - pendingFreeProxies.size() * 2);
+        }
+        //消したproxy同士は同じ値で並ぶので追い越しが起きない. 残ったペアをここで外す
+        if(!pendingFreeProxies.empty()){
+            for(int i = (int)pairKeys.size() - 1; i >= 0; --i){
+                int a = (int)(pairKeys[i] >> 32);
+                int b = (int)(pairKeys[i] & 0xffffffff);
+                if(proxies[a].aabb.min.x == FLT_MAX || proxies[b].aabb.min.x == FLT_MAX){
+                    RemovePair(a, b);
+                }
+            }
+        }
+        FlushEvents();
+    }
+
+    bool SweepAndPrune::IsOverlap(int a, int b) const {
+        if(a == b){
+            return false;
+        }
+        const AABBCollision& lhs = proxies[a].aabb;
+        const AABBCollision& rhs = proxies[b].aabb;
+        //消したproxy同士は無限遠で重なってしまうので除く
+        if(lhs.min.x == FLT_MAX || rhs.min.x == FLT_MAX){
+            return false;
+        }
+        return !(lhs.max.x < rhs.min.x || lhs.min.x > rhs.max.x ||
+                 lhs.max.y < rhs.min.y || lhs.min.y > rhs.max.y ||
+                 lhs.max.z < rhs.min.z || lhs.min.z > rhs.max.z);
+    }
+
+    void SweepAndPrune::SetEndPointIndex(int axis, int index){
+        const EndPoint& endPoint = axes[axis][index];
+        if(endPoint.IsMax()){
+            proxies[endPoint.ProxyId()].maxIndex[axis] = index;
+        }
+        else {
+            proxies[endPoint.ProxyId()].minIndex[axis] = index;
+        }
+    }
+
+    void SweepAndPrune::SortDown(int axis, int index){
+        std::vector<EndPoint>& endPoints = axes[axis];
+        EndPoint endPoint = endPoints[index];
+        while(index > 0){
+            const EndPoint& prev = endPoints[index - 1];
+            if(!Less(endPoint.value, endPoint.IsMax(), prev.value, prev.IsMax())){
+                break;
+            }
+            if(!endPoint.IsMax() && prev.IsMax()){
+                //minが他のmaxを左に追い越した -> 重なり始める可能性
+                if(IsOverlap(endPoint.ProxyId(), prev.ProxyId())){
+                    AddPair(endPoint.ProxyId(), prev.ProxyId());
+                }
+            }
+            else if(endPoint.IsMax() && !prev.IsMax()){
+                //maxが他のminを左に追い越した -> 離れた
+                RemovePair(endPoint.ProxyId(), prev.ProxyId());
+            }
+            endPoints[index] = prev;
+            SetEndPointIndex(axis, index);
+            --index;
+        }
+        endPoints[index] = endPoint;
+        SetEndPointIndex(axis, index);
+    }
+
+    void SweepAndPrune::AddPair(int a, int b){
+        uint64_t key = PairKey(a, b);
+        if(pairIndex.find(key) != pairIndex.end()){
+            return;
+        }
+        touchedPairs.emplace(key, false);
+        if(a > b){
+            std::swap(a, b);
+        }
+        pairIndex[key] = (int)pairs.size();
+        pairs.emplace_back(proxies[a].userData, proxies[b].userData);
+        pairKeys.push_back(key);
+    }
+
+    void SweepAndPrune::RemovePair(int a, int b){
+        uint64_t key = PairKey(a, b);
+        auto itr = pairIndex.find(key);
+        if(itr == pairIndex.end()){
+            return;
+        }
+        touchedPairs.emplace(key, true);
+        int index = itr->second;
+        int last = (int)pairs.size() - 1;
+        if(index != last){
+            pairs[index] = pairs[last];
+            pairKeys[index] = pairKeys[last];
+            pairIndex[pairKeys[index]] = index;
+        }
+        pairs.pop_back();
+        pairKeys.pop_back();
+        pairIndex.erase(key);
+    }
+
+    void SweepAndPrune::FlushEvents(){
+        addedPairs.clear();
+        removedPairs.clear();
+        for(auto& touched : touchedPairs){
+            bool isPair = pairIndex.find(touched.first) != pairIndex.end();
+            if(isPair == touched.second){
+                continue;
+            }
+            int a = (int)(touched.first >> 32);
+            int b = (int)(touched.first & 0xffffffff);
+            if(isPair){
+                addedPairs.emplace_back(proxies[a].userData, proxies[b].userData);
+            }
+            else {
+                removedPairs.emplace_back(proxies[a].userData, proxies[b].userData);
+            }
+        }
+        touchedPairs.clear();
+        for(int proxyId : pendingFreeProxies){
+            proxies[proxyId].userData = -1;
+            freeProxies.push_back(proxyId);
+        }
+        pendingFreeProxies.clear();
+    }
+}// namespace myTools
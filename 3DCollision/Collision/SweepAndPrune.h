@@ -0,0 +1,117 @@
+//
+//  SweepAndPrune.h
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/23.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#ifndef SweepAndPrune_h
+#define SweepAndPrune_h
+
+#include "Primitive.h"
+#include <vector>
+#include <utility>
+#include <unordered_map>
+#include <stdint.h>
+
+namespace myTools {
+
+    /**
+     *  @tips   Keeps the endpoint arrays of the 3 axes across frames and re-sorts them by insertion sort.
+     *          Overlapping pairs are kept persistently and only added / removed pairs are reported as events.
+     *          When most objects move only a little, the cost follows how far they move.
+     */
+    class SweepAndPrune {
+    public:
+        /**
+         *  @tips   AddProxy / RemoveProxy are applied (and their pair events are built) in the next Update()
+         */
+        int AddProxy(const AABBCollision& aabb, int userData);
+        void RemoveProxy(int proxyId);
+
+        /**
+         *  @tips   Only stores the new aabb. Call Update() once after all proxies are updated.
+         */
+        void UpdateProxy(int proxyId, const AABBCollision& aabb);
+
+        /**
+         *  @tips   Re-sort the endpoints and build added / removed pair events.
+         */
+        void Update();
+
+        int GetUserData(int proxyId) const {
+            return proxies[proxyId].userData;
+        }
+
+        /**
+         *  @tips   Every overlapping pair as (userData, userData)
+         */
+        const std::vector<std::pair<int,int>>& GetPairs() const {
+            return pairs;
+        }
+        /**
+         *  @tips   Pairs which started overlapping since the previous Update (AddProxy included)
+         */
+        const std::vector<std::pair<int,int>>& GetAddedPairs() const {
+            return addedPairs;
+        }
+        /**
+         *  @tips   Pairs which stopped overlapping since the previous Update (RemoveProxy included)
+         */
+        const std::vector<std::pair<int,int>>& GetRemovedPairs() const {
+            return removedPairs;
+        }
+
+    private:
+        struct EndPoint {
+            float value;
+            //proxyId << 1 | isMax
+            uint32_t data;
+            int ProxyId() const {
+                return (int)(data >> 1);
+            }
+            bool IsMax() const {
+                return (data & 1) != 0;
+            }
+        };
+        struct Proxy {
+            AABBCollision aabb;
+            int userData = -1;
+            int minIndex[3];
+            int maxIndex[3];
+        };
+
+        static uint64_t PairKey(int a, int b){
+            if(a > b){
+                std::swap(a, b);
+            }
+            return ((uint64_t)a << 32) | (uint32_t)b;
+        }
+
+        bool IsOverlap(int a, int b) const;
+        void SetEndPointIndex(int axis, int index);
+        void SortDown(int axis, int index);
+        void AddPair(int a, int b);
+        void RemovePair(int a, int b);
+        void FlushEvents();
+
+        std::vector<EndPoint> axes[3];
+        std::vector<Proxy> proxies;
+        std::vector<int> freeProxies;
+        //イベントを出し終わるまでは消したproxyのuserDataを残しておく
+        std::vector<int> pendingFreeProxies;
+
+        std::vector<std::pair<int,int>> pairs;
+        std::vector<uint64_t> pairKeys;
+        //ペアのキー -> pairsの添字
+        std::unordered_map<uint64_t, int> pairIndex;
+
+        //今回のUpdateで触ったペアと、触る前に重なっていたかどうか
+        std::unordered_map<uint64_t, bool> touchedPairs;
+        std::vector<std::pair<int,int>> addedPairs;
+        std::vector<std::pair<int,int>> removedPairs;
+    };
+}// namespace myTools
+
+#endif /* SweepAndPrune_h */
@@ -0,0 +1,133 @@
+//
+//  JobSystem.cpp
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/29.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#include "JobSystem.h"
+
+namespace myTools {
+
+    namespace {
+        //threadIndex は threadOwner のワーカーとしての番号
+        thread_local const JobSystem* threadOwner = nullptr;
+        thread_local int threadIndex = 0;
+    }
+
+    JobSystem::JobSystem(int threadCount){
+        if(threadCount <= 0){
+            threadCount = (int)std::thread::hardware_concurrency();
+            if(threadCount <= 0){
+                threadCount = 1;
+            }
+        }
+        for(int i = 0; i < threadCount; ++i){
+            queues.push_back(std::unique_ptr<Queue>(new Queue()));
+        }
+        for(int i = 1; i < threadCount; ++i){
+            threads.push_back(std::thread(&JobSystem::WorkerMain, this, i));
+        }
+    }
+
+    JobSystem::~JobSystem(){
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+            quit = true;
+        }
+        wakeUp.notify_all();
+        for(auto& thread : threads){
+            thread.join();
+        }
+    }
+
+    int JobSystem::GetThreadIndex() const {
+        return threadOwner == this ? threadIndex : 0;
+    }
+
+    void JobSystem::Run(Counter& counter, std::function<void()> func){
+        counter.count.fetch_add(1, std::memory_order_relaxed);
+        Job job;
+        job.func = std::move(func);
+        job.counter = &counter;
+        if(threads.empty()){
+            Execute(job);
+            return;
+        }
+        Queue& queue = *queues[GetThreadIndex()];
+        {
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            queue.jobs.push_back(std::move(job));
+        }
+        queuedCount.fetch_add(1, std::memory_order_release);
+        //寝る直前のワーカーが見逃さないように一度ロックを取ってから起こす
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex);
+        }
+        wakeUp.notify_one();
+    }
+
+    void JobSystem::Wait(Counter& counter){
+        while(counter.count.load(std::memory_order_acquire) > 0){
+            Job job;
+            if(Take(GetThreadIndex(), job)){
+                Execute(job);
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    bool JobSystem::Take(int thread, Job& job){
+        //自分のキューは後ろから
+        {
+            Queue& queue = *queues[thread];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if(!queue.jobs.empty()){
+                job = std::move(queue.jobs.back());
+                queue.jobs.pop_back();
+                queuedCount.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        //他のスレッドのキューは前から盗む
+        int count = GetThreadCount();
+        for(int i = 1; i < count; ++i){
+            Queue& queue = *queues[(thread + i) % count];
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if(!queue.jobs.empty()){
+                job = std::move(queue.jobs.front());
+                queue.jobs.pop_front();
+                queuedCount.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void JobSystem::Execute(Job& job){
+        job.func();
+        job.counter->count.fetch_sub(1, std::memory_order_release);
+    }
+
+    void JobSystem::WorkerMain(int thread){
+        threadOwner = this;
+        threadIndex = thread;
+        while(true){
+            Job job;
+            if(Take(thread, job)){
+                Execute(job);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleepMutex);
+            wakeUp.wait(lock, [this]{
+                return quit || queuedCount.load(std::memory_order_acquire) > 0;
+            });
+            if(quit){
+                return;
+            }
+        }
+    }
+}// namespace myTools
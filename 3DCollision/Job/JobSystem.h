@@ -0,0 +1,114 @@
+//
+//  JobSystem.h
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/29.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#ifndef JobSystem_h
+#define JobSystem_h
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace myTools {
+
+    /**
+     *  @tips   Work-stealing job scheduler.
+     *          Each thread has a deque. It takes from the back of its own (LIFO)
+     *          and steals from the front of the others.
+     *          The creating thread counts as thread 0 and runs jobs while it Waits.
+     *          Call Run / Wait / ParallelFor from the creating thread or from inside a job.
+     *          Workers of another JobSystem are treated like the creating thread (index 0)
+     */
+    class JobSystem {
+    public:
+        //ジョブの残り数. 0 になったら終わり
+        struct Counter {
+            std::atomic<int> count{0};
+        };
+
+        /**
+         *  @tips   threadCount includes the calling thread. 0 uses every hardware thread.
+         */
+        explicit JobSystem(int threadCount = 0);
+        ~JobSystem();
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        int GetThreadCount() const {
+            return (int)queues.size();
+        }
+        //今のスレッドのこの JobSystem での番号(0 ～ GetThreadCount() - 1). スレッドごとの作業領域の添字に使う
+        int GetThreadIndex() const;
+
+        void Run(Counter& counter, std::function<void()> func);
+        /**
+         *  @tips   Execute jobs until counter reaches 0
+         */
+        void Wait(Counter& counter);
+
+        /**
+         *  @tips   Call func(first, last) over [first, last) split into ranges of at most grain.
+         *          Ranges are split in half recursively so idle threads steal large pieces.
+         *          Returns when every range has been processed.
+         */
+        template<typename Func>
+        void ParallelFor(int first, int last, int grain, const Func& func){
+            if(last <= first){
+                return;
+            }
+            if(grain < 1){
+                grain = 1;
+            }
+            if(threads.empty() || last - first <= grain){
+                func(first, last);
+                return;
+            }
+            Counter counter;
+            std::function<void(int,int)> split = [&](int first, int last){
+                while(last - first > grain){
+                    int mid = first + (last - first) / 2;
+                    Run(counter, [&split, mid, last]{
+                        split(mid, last);
+                    });
+                    last = mid;
+                }
+                func(first, last);
+            };
+            split(first, last);
+            Wait(counter);
+        }
+
+    private:
+        struct Job {
+            std::function<void()> func;
+            Counter* counter = nullptr;
+        };
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Job> jobs;
+        };
+
+        bool Take(int thread, Job& job);
+        void Execute(Job& job);
+        void WorkerMain(int thread);
+
+        std::vector<std::unique_ptr<Queue>> queues;
+        std::vector<std::thread> threads;
+        //キューに入っているジョブの数(寝ているワーカーを起こすかの判断用)
+        std::atomic<int> queuedCount{0};
+        std::atomic<bool> quit{false};
+        std::mutex sleepMutex;
+        std::condition_variable wakeUp;
+    };
+}// namespace myTools
+
+#endif /* JobSystem_h */
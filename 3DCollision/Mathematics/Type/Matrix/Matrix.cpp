@@ -11,16 +11,10 @@
 
 namespace myTools{
         Matrix4x4& Matrix4x4::operator+=(const Matrix4x4& mat){
-            for(int i = 0; i < 16; ++i){
-                m[i] += mat.m[i];
-            }
-            return *this;
+            return (*this = *this + mat);
         }
         Matrix4x4& Matrix4x4::operator-=(const Matrix4x4& mat){
-            for(int i = 0; i < 16; ++i){
-                m[i] -= mat.m[i];
-            }
-            return *this;
+            return (*this = *this - mat);
         }
         Matrix4x4& Matrix4x4::operator*=(const Matrix4x4& mat){
             return (*this = *this * mat);
@@ -39,58 +33,6 @@ namespace myTools{
             return *this;
         }
         
-        Matrix4x4 operator+(const Matrix4x4& a, const Matrix4x4& b){
-            Matrix4x4 ret;
-            for(int i = 0; i < 16; ++i){
-                ret.m[i] = a.m[i] + b.m[i];
-            }
-            return ret;
-        }
-        
-        Matrix4x4 operator-(const Matrix4x4& a, const Matrix4x4& b){
-            Matrix4x4 ret;
-            for(int i = 0; i < 16; ++i){
-                ret.m[i] = a.m[i] - b.m[i];
-            }
-            return ret;
-        }
-        Matrix4x4 operator*(const Matrix4x4& mat, const float& s){
-            Matrix4x4 ret;
-            for(int i = 0; i < 16; ++i){
-                ret.m[i] = mat.m[i] * s;
-            }
-            return ret;
-        }
-        Matrix4x4 operator/(const Matrix4x4& mat, const float& s){
-            Matrix4x4 ret;
-            float dev = 1.0f / s;
-            for(int i = 0; i < 16; ++i){
-                ret.m[i] = mat.m[i] * dev;
-            }
-            return ret;
-        }
-        
-        Matrix4x4 operator*(const Matrix4x4& a, const Matrix4x4& b){
-            Matrix4x4 ret(0);
-            for(int i = 0; i < 4; ++i){
-                for(int j = 0; j < 4; ++j){
-                    for(int k = 0; k < 4; ++k){
-                        ret[j][i] += a[k][i] * b[j][k];
-                    }
-                }
-            }
-            return ret;
-        }
-        Vector4 operator*(const Matrix4x4& mat, const Vector4& vec){
-            Vector4 ret(0,0,0,0);
-            for(int i = 0; i < 4; ++i){
-                for(int j = 0; j < 4; ++j){
-                    ret[i] += mat[j][i] * vec[j];
-                }
-            }
-            return ret;
-        }
-        
         void print(const Matrix4x4& m){
             for(int i = 0; i < 4; ++i){
                 for(int j = 0; j < 4; ++j){
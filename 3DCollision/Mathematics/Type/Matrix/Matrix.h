@@ -14,7 +14,8 @@
 #include <iostream>
 
 namespace myTools{
-        struct Matrix4x4{
+        //列ごとのVector4が16バイト境界に並ぶ
+        struct alignas(16) Matrix4x4{
             Matrix4x4(float d = 1){
                 for(int i = 0; i < 16; ++i){
                     m[i] = 0;
@@ -60,13 +61,102 @@ namespace myTools{
             
         };
         
-        Matrix4x4 operator+(const Matrix4x4& a, const Matrix4x4& b);
-        Matrix4x4 operator-(const Matrix4x4& a, const Matrix4x4& b);
-        Matrix4x4 operator*(const Matrix4x4& mat, const float& s);
-        Matrix4x4 operator/(const Matrix4x4& mat, const float& s);
+        inline Matrix4x4 operator+(const Matrix4x4& a, const Matrix4x4& b){
+            Matrix4x4 ret;
+            for(int i = 0; i < 4; ++i){
+                ret.v[i] = a.v[i] + b.v[i];
+            }
+            return ret;
+        }
+        
+        inline Matrix4x4 operator-(const Matrix4x4& a, const Matrix4x4& b){
+            Matrix4x4 ret;
+            for(int i = 0; i < 4; ++i){
+                ret.v[i] = a.v[i] - b.v[i];
+            }
+            return ret;
+        }
+        inline Matrix4x4 operator*(const Matrix4x4& mat, const float& s){
+            Matrix4x4 ret;
+            for(int i = 0; i < 4; ++i){
+                ret.v[i] = mat.v[i] * s;
+            }
+            return ret;
+        }
+        inline Matrix4x4 operator/(const Matrix4x4& mat, const float& s){
+            return mat * (1.0f / s);
+        }
         
-        Matrix4x4 operator*(const Matrix4x4& a, const Matrix4x4& b);
-        Vector4 operator*(const Matrix4x4& mat, const Vector4& vec);
+        //列優先なので ret.v[j] = Σ a.v[k] * b[j][k]
+#if defined(MT_USE_AVX)
+        inline Matrix4x4 operator*(const Matrix4x4& a, const Matrix4x4& b){
+            Matrix4x4 ret;
+            //aの列を上下の128bitに同じものを並べておき、bの2列ずつまとめて計算する
+            __m256 a0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a.v[0].d));
+            __m256 a1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a.v[1].d));
+            __m256 a2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a.v[2].d));
+            __m256 a3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(a.v[3].d));
+            for(int j = 0; j < 4; j += 2){
+                __m256 bj = _mm256_loadu_ps(b.v[j].d);
+                __m256 r = _mm256_mul_ps(a0, _mm256_permute_ps(bj, _MM_SHUFFLE(0, 0, 0, 0)));
+                r = _mm256_add_ps(r, _mm256_mul_ps(a1, _mm256_permute_ps(bj, _MM_SHUFFLE(1, 1, 1, 1))));
+                r = _mm256_add_ps(r, _mm256_mul_ps(a2, _mm256_permute_ps(bj, _MM_SHUFFLE(2, 2, 2, 2))));
+                r = _mm256_add_ps(r, _mm256_mul_ps(a3, _mm256_permute_ps(bj, _MM_SHUFFLE(3, 3, 3, 3))));
+                _mm256_storeu_ps(ret.v[j].d, r);
+            }
+            return ret;
+        }
+#elif defined(MT_USE_SSE)
+        inline Matrix4x4 operator*(const Matrix4x4& a, const Matrix4x4& b){
+            Matrix4x4 ret;
+            __m128 a0 = Load(a.v[0]);
+            __m128 a1 = Load(a.v[1]);
+            __m128 a2 = Load(a.v[2]);
+            __m128 a3 = Load(a.v[3]);
+            for(int j = 0; j < 4; ++j){
+                __m128 bj = Load(b.v[j]);
+                __m128 r = _mm_mul_ps(a0, MtSplat<0>(bj));
+                r = _mm_add_ps(r, _mm_mul_ps(a1, MtSplat<1>(bj)));
+                r = _mm_add_ps(r, _mm_mul_ps(a2, MtSplat<2>(bj)));
+                r = _mm_add_ps(r, _mm_mul_ps(a3, MtSplat<3>(bj)));
+                _mm_store_ps(ret.v[j].d, r);
+            }
+            return ret;
+        }
+#else
+        inline Matrix4x4 operator*(const Matrix4x4& a, const Matrix4x4& b){
+            Matrix4x4 ret(0);
+            for(int i = 0; i < 4; ++i){
+                for(int j = 0; j < 4; ++j){
+                    for(int k = 0; k < 4; ++k){
+                        ret[j][i] += a[k][i] * b[j][k];
+                    }
+                }
+            }
+            return ret;
+        }
+#endif
+        
+#if defined(MT_USE_SSE)
+        inline Vector4 operator*(const Matrix4x4& mat, const Vector4& vec){
+            __m128 v = Load(vec);
+            __m128 r = _mm_mul_ps(Load(mat.v[0]), MtSplat<0>(v));
+            r = _mm_add_ps(r, _mm_mul_ps(Load(mat.v[1]), MtSplat<1>(v)));
+            r = _mm_add_ps(r, _mm_mul_ps(Load(mat.v[2]), MtSplat<2>(v)));
+            r = _mm_add_ps(r, _mm_mul_ps(Load(mat.v[3]), MtSplat<3>(v)));
+            return ToVector4(r);
+        }
+#else
+        inline Vector4 operator*(const Matrix4x4& mat, const Vector4& vec){
+            Vector4 ret(0,0,0,0);
+            for(int i = 0; i < 4; ++i){
+                for(int j = 0; j < 4; ++j){
+                    ret[i] += mat[j][i] * vec[j];
+                }
+            }
+            return ret;
+        }
+#endif
         
         void print(const Matrix4x4&);
         
@@ -0,0 +1,48 @@
+//
+//  Simd.h
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/27.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#ifndef Simd_h
+#define Simd_h
+
+//Vector4 / Matrix4x4 の演算をSIMDで行うかどうかをコンパイル時に選ぶ.
+//  MT_NO_SIMD を定義すると常にスカラー版
+//  SSE2が使えるなら MT_USE_SSE, さらにAVXが使えるなら MT_USE_AVX が定義される
+#if !defined(MT_NO_SIMD)
+#   if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#       define MT_USE_SSE
+#   endif
+#   if defined(MT_USE_SSE) && defined(__AVX__)
+#       define MT_USE_AVX
+#   endif
+#endif
+
+#if defined(MT_USE_AVX)
+#include <immintrin.h>
+#elif defined(MT_USE_SSE)
+#include <emmintrin.h>
+#endif
+
+#if defined(MT_USE_SSE)
+namespace myTools {
+    //全要素にi番目の要素を並べる
+    template<int i>
+    inline __m128 MtSplat(__m128 v){
+        return _mm_shuffle_ps(v, v, _MM_SHUFFLE(i, i, i, i));
+    }
+
+    //4要素の合計を全要素に入れて返す
+    inline __m128 MtHorizontalSum(__m128 v){
+        __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+        __m128 sums = _mm_add_ps(v, shuf);
+        shuf = _mm_shuffle_ps(sums, sums, _MM_SHUFFLE(1, 0, 3, 2));
+        return _mm_add_ps(sums, shuf);
+    }
+}// namespace myTools
+#endif
+
+#endif /* Simd_h */
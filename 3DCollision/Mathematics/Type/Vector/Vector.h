@@ -11,6 +11,8 @@
 
 #include <iostream>
 #include <float.h>
+#include <math.h>
+#include "Simd.h"
 
 #define MT_EPSILON  0.00001f
 
@@ -27,7 +29,9 @@ namespace myTools{
         : x(x), y(y)
         {}
         
-        float Norm() const ;
+        float Norm() const {
+            return sqrtf(x * x + y * y);
+        }
         
         Vector2& operator+=(const Vector2& v){
             x += v.x;
@@ -55,16 +59,32 @@ namespace myTools{
         }
     };
     
-    Vector2 operator+(const Vector2& v1, const Vector2& v2);
-    Vector2 operator-(const Vector2& v1, const Vector2& v2);
-    Vector2 operator*(const Vector2& v, float scaler);
-    Vector2 operator*(float scaler, const Vector2& v);
-    Vector2 operator/(const Vector2& v, float scaler);
-    Vector2 operator/(float scaler, const Vector2& v);
+    inline Vector2 operator+(const Vector2& v1, const Vector2& v2){
+        return Vector2(v1.x + v2.x, v1.y + v2.y);
+    }
+    inline Vector2 operator-(const Vector2& v1, const Vector2& v2){
+        return Vector2(v1.x - v2.x, v1.y - v2.y);
+    }
+    inline Vector2 operator*(const Vector2& v, float scaler){
+        return Vector2(v.x * scaler, v.y * scaler);
+    }
+    inline Vector2 operator*(float scaler, const Vector2& v){
+        return Vector2(v.x * scaler, v.y * scaler);
+    }
+    inline Vector2 operator/(const Vector2& v,float scaler){
+        return Vector2(v.x / scaler, v.y / scaler);
+    }
+    inline Vector2 operator/(float scaler, const Vector2& v){
+        return Vector2(v.x / scaler, v.y / scaler);
+    }
     
-    bool operator==(const Vector2& v1, const Vector2 v2);
+    inline bool operator==(const Vector2& v1, const Vector2 v2){
+        return v1.x == v2.x && v1.y == v2.y;
+    }
     
-    Vector2 operator-(const Vector2&);
+    inline Vector2 operator-(const Vector2& v){
+        return Vector2(-v.x, -v.y);
+    }
     struct Vector3 {
         union {
             float d[3];
@@ -83,8 +103,12 @@ namespace myTools{
         {
         }
         
-        float Length() const ;
-        float LengthSq() const ;
+        float Length() const {
+            return sqrtf(x * x + y * y + z * z);
+        }
+        float LengthSq() const {
+            return x * x + y * y + z * z;
+        }
         
         Vector3& operator+=(const Vector3& v){
             x += v.x;
@@ -119,18 +143,38 @@ namespace myTools{
         }
     };
     
-    Vector3 operator+(const Vector3& v1, const Vector3& v2);
-    Vector3 operator-(const Vector3& v1, const Vector3& v2);
-    Vector3 operator*(const Vector3& v, float scaler);
-    Vector3 operator*(float scaler, const Vector3& v);
-    Vector3 operator/(const Vector3& v, float scaler);
-    Vector3 operator/(float scaler, const Vector3& v);
+    //Vector3は12バイトのまま(頂点や配列に詰めて使っているので)インラインのスカラー演算にしている
+    inline Vector3 operator+(const Vector3& v1, const Vector3& v2){
+        return Vector3(v1.x + v2.x, v1.y + v2.y, v1.z + v2.z);
+    }
+    inline Vector3 operator-(const Vector3& v1, const Vector3& v2){
+        return Vector3(v1.x - v2.x, v1.y - v2.y, v1.z - v2.z);
+    }
+    inline Vector3 operator*(const Vector3& v, float scaler){
+        return Vector3(v.x * scaler, v.y * scaler, v.z * scaler);
+    }
+    inline Vector3 operator*(float scaler, const Vector3& v){
+        return Vector3(v.x * scaler, v.y * scaler, v.z * scaler);
+    }
+    inline Vector3 operator/(const Vector3& v,float scaler){
+        return Vector3(v.x / scaler, v.y / scaler, v.z / scaler);
+    }
+    inline Vector3 operator/(float scaler, const Vector3& v){
+        return Vector3(v.x / scaler, v.y / scaler, v.z / scaler);
+    }
     
-    bool operator==(const Vector3& v1, const Vector3& v2);
-    bool operator==(const Vector3& v, const float& t);
-    Vector3 operator-(const Vector3&);
+    inline bool operator==(const Vector3& v1, const Vector3& v2){
+        return fabsf(v1.x - v2.x) < MT_EPSILON && fabsf(v1.y - v2.y) < MT_EPSILON && fabsf(v1.z - v2.z) < MT_EPSILON;
+    }
+    inline bool operator==(const Vector3& v, const float& t){
+        return fabsf(v.x - t) < MT_EPSILON && fabsf(v.y - t) < MT_EPSILON && fabsf(v.z - t) < MT_EPSILON;
+    }
+    inline Vector3 operator-(const Vector3& v){
+        return Vector3(-v.x, -v.y, -v.z);
+    }
     
-    struct Vector4 {
+    //SIMDでそのまま読み書きできるように16バイト境界に置く
+    struct alignas(16) Vector4 {
         union {
             float d[4];
             struct { float x,y,z,w;};
@@ -153,7 +197,9 @@ namespace myTools{
         {
         }
         
-        float Norm() const ;
+        float Norm() const {
+            return sqrtf(x * x + y * y + z * z + w * w);
+        }
         
         Vector4& operator+=(const Vector4& v){
             x += v.x;
@@ -192,30 +238,113 @@ namespace myTools{
         }
     };
     
-    Vector4 operator+(const Vector4& v1, const Vector4& v2);
-    Vector4 operator-(const Vector4& v1, const Vector4& v2);
-    Vector4 operator*(const Vector4& v, float scaler);
-    Vector4 operator*(float scaler, const Vector4& v);
-    Vector4 operator/(const Vector4& v, float scaler);
-    Vector4 operator/(float scaler, const Vector4& v);
-    
-    bool operator==(const Vector4& v1, const Vector4& v2);
+#if defined(MT_USE_SSE)
+    inline __m128 Load(const Vector4& v){
+        return _mm_load_ps(v.d);
+    }
+    inline Vector4 ToVector4(__m128 v){
+        Vector4 ret;
+        _mm_store_ps(ret.d, v);
+        return ret;
+    }
+    inline Vector4 operator+(const Vector4& v1, const Vector4& v2){
+        return ToVector4(_mm_add_ps(Load(v1), Load(v2)));
+    }
+    inline Vector4 operator-(const Vector4& v1, const Vector4& v2){
+        return ToVector4(_mm_sub_ps(Load(v1), Load(v2)));
+    }
+    inline Vector4 operator*(const Vector4& v, float scaler){
+        return ToVector4(_mm_mul_ps(Load(v), _mm_set1_ps(scaler)));
+    }
+    inline Vector4 operator*(float scaler, const Vector4& v){
+        return v * scaler;
+    }
+    inline Vector4 operator/(const Vector4& v, float scaler){
+        return ToVector4(_mm_div_ps(Load(v), _mm_set1_ps(scaler)));
+    }
+    inline Vector4 operator/(float scaler, const Vector4& v){
+        return v / scaler;
+    }
+    inline Vector4 operator-(const Vector4& v){
+        return ToVector4(_mm_sub_ps(_mm_setzero_ps(), Load(v)));
+    }
+#else
+    inline Vector4 operator+(const Vector4& v1, const Vector4& v2){
+        return Vector4(v1.x + v2.x, v1.y + v2.y, v1.z + v2.z, v1.w + v2.w);
+    }
+    inline Vector4 operator-(const Vector4& v1, const Vector4& v2){
+        return Vector4(v1.x - v2.x, v1.y - v2.y, v1.z - v2.z, v1.w - v2.w);
+    }
+    inline Vector4 operator*(const Vector4& v, float scaler){
+        return Vector4(v.x * scaler, v.y * scaler, v.z * scaler, v.w * scaler);
+    }
+    inline Vector4 operator*(float scaler, const Vector4& v){
+        return Vector4(v.x * scaler, v.y * scaler, v.z * scaler, v.w * scaler);
+    }
+    inline Vector4 operator/(const Vector4& v,float scaler){
+        return Vector4(v.x / scaler, v.y / scaler, v.z / scaler, v.w / scaler);
+    }
+    inline Vector4 operator/(float scaler, const Vector4& v){
+        return Vector4(v.x / scaler, v.y / scaler, v.z / scaler, v.w / scaler);
+    }
+    inline Vector4 operator-(const Vector4& v){
+        return Vector4(-v.x, -v.y, -v.z, -v.w);
+    }
+#endif
     
-    Vector4 operator-(const Vector4&);
+    inline bool operator==(const Vector4& v1, const Vector4& v2){
+        return v1.x == v2.x && v1.y == v2.y && v1.z == v2.z && v1.w == v2.w;
+    }
     
     void print(const Vector2&);
     void print(const Vector3&);
     void print(const Vector4&);
     
-    float dot(const Vector2&, const Vector2&);
-    float dot(const Vector3&, const Vector3&);
-    float dot(const Vector4&, const Vector4&);
-    float cross(const Vector2&, const Vector2&);
-    Vector3 cross(const Vector3&, const Vector3&);
+    inline float dot(const Vector2& a, const Vector2& b){
+        return a.x * b.x + a.y * b.y;
+    }
+    inline float dot(const Vector3& a, const Vector3& b){
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+    inline float cross(const Vector2& a, const Vector2& b){
+        return a.x * b.y - a.y * b.x;
+    }
+    inline Vector3 cross(const Vector3& a, const Vector3& b){
+        return Vector3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+    }
+    
+    inline Vector2 Normalize(const Vector2& v){
+        float sq = sqrtf(dot(v, v));
+        float normalize = sq != 0 ?  1 / sq : 0;
+        return Vector2(v.x * normalize, v.y * normalize);
+    }
+    inline Vector3 Normalize(const Vector3& v){
+        float sq = sqrtf(dot(v,v));
+        float normalize = sq != 0 ?  1 / sq : 0;
+        return Vector3(v.x * normalize, v.y * normalize, v.z * normalize);
+    }
     
-    Vector2 Normalize(const Vector2& v);
-    Vector3 Normalize(const Vector3& v);
-    Vector4 Normalize(const Vector4& v);
+#if defined(MT_USE_SSE)
+    inline float dot(const Vector4& a, const Vector4& b){
+        return _mm_cvtss_f32(MtHorizontalSum(_mm_mul_ps(Load(a), Load(b))));
+    }
+    inline Vector4 Normalize(const Vector4& v){
+        __m128 vec = Load(v);
+        __m128 sq = _mm_sqrt_ps(MtHorizontalSum(_mm_mul_ps(vec, vec)));
+        //長さ0のときは0ベクトル
+        __m128 mask = _mm_cmpneq_ps(sq, _mm_setzero_ps());
+        return ToVector4(_mm_and_ps(_mm_div_ps(vec, sq), mask));
+    }
+#else
+    inline float dot(const Vector4& a, const Vector4& b){
+        return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    }
+    inline Vector4 Normalize(const Vector4& v){
+        float sq = sqrtf(dot(v, v));
+        float normalize = sq != 0 ?  1 / sq : 0;
+        return Vector4(v.x * normalize, v.y * normalize, v.z * normalize, v.w * normalize);
+    }
+#endif
     
     bool IsParallel(const Vector2& v1, const Vector2& v2);
     bool IsParallel(const Vector3& v1, const Vector3& v2);
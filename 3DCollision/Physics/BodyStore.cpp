@@ -0,0 +1,214 @@
+//
+//  BodyStore.cpp
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/26.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#include "BodyStore.h"
+#include "Physics.h"
+#include "JobSystem.h"
+
+namespace myTools {
+
+    BodyHandle BodyStore::Create(const Vector3& position, float mass){
+        int slotIndex;
+        if(freeSlot == -1){
+            slotIndex = (int)slots.size();
+            slots.push_back(Slot());
+        }
+        else {
+            slotIndex = freeSlot;
+            freeSlot = slots[slotIndex].dense;
+        }
+        int dense = (int)this->position.size();
+        slots[slotIndex].dense = dense;
+
+        this->position.push_back(position);
+        velocity.push_back(Vector3());
+        acceleration.push_back(Vector3());
+        prePos.push_back(position);
+        preVel.push_back(Vector3());
+        this->mass.push_back(mass);
+        massRate.push_back(1 / mass);
+        sleeping.push_back(0);
+        denseToSlot.push_back(slotIndex);
+
+        BodyHandle handle;
+        handle.index = slotIndex;
+        handle.generation = slots[slotIndex].generation;
+        return handle;
+    }
+
+    BodyHandle BodyStore::Create(const Physics& phys){
+        BodyHandle handle = Create(phys.GetPosition(), phys.GetMass());
+        Velocity(handle) = phys.GetVelocity();
+        Acceleration(handle) = phys.GetAcceleration();
+        return handle;
+    }
+
+    void BodyStore::Destroy(BodyHandle handle){
+        if(!IsValid(handle)){
+            return;
+        }
+        //最後の物体を空いたところに移して詰める
+        int dense = slots[handle.index].dense;
+        int last = (int)position.size() - 1;
+        if(dense != last){
+            position[dense] = position[last];
+            velocity[dense] = velocity[last];
+            acceleration[dense] = acceleration[last];
+            prePos[dense] = prePos[last];
+            preVel[dense] = preVel[last];
+            mass[dense] = mass[last];
+            massRate[dense] = massRate[last];
+            sleeping[dense] = sleeping[last];
+            denseToSlot[dense] = denseToSlot[last];
+            slots[denseToSlot[dense]].dense = dense;
+        }
+        position.pop_back();
+        velocity.pop_back();
+        acceleration.pop_back();
+        prePos.pop_back();
+        preVel.pop_back();
+        mass.pop_back();
+        massRate.pop_back();
+        sleeping.pop_back();
+        denseToSlot.pop_back();
+
+        Slot& slot = slots[handle.index];
+        ++slot.generation;
+        slot.dense = freeSlot;
+        freeSlot = handle.index;
+    }
+
+    bool BodyStore::IsValid(BodyHandle handle) const {
+        return 0 <= handle.index && handle.index < (int)slots.size() &&
+        slots[handle.index].generation == handle.generation;
+    }
+
+    void BodyStore::Reserve(int count){
+        position.reserve(count);
+        velocity.reserve(count);
+        acceleration.reserve(count);
+        prePos.reserve(count);
+        preVel.reserve(count);
+        mass.reserve(count);
+        massRate.reserve(count);
+        sleeping.reserve(count);
+        denseToSlot.reserve(count);
+        slots.reserve(count);
+    }
+
+    void BodyStore::SetMass(BodyHandle handle, float mass){
+        int dense = GetIndex(handle);
+        this->mass[dense] = mass;
+        massRate[dense] = 1 / mass;
+    }
+
+    void BodyStore::SetSleeping(BodyHandle handle, bool isSleeping){
+        int dense = GetIndex(handle);
+        sleeping[dense] = isSleeping ? 1 : 0;
+        if(isSleeping){
+            //止めておく. 移動後の位置も今の位置にしておけば判定はそのまま使える
+            velocity[dense] = Vector3();
+            acceleration[dense] = Vector3();
+            prePos[dense] = position[dense];
+            preVel[dense] = Vector3();
+        }
+    }
+
+    void BodyStore::AddAcceleration(const Vector3& difAcc){
+        int count = GetCount();
+        Vector3* acc = acceleration.data();
+        const char* isSleeping = sleeping.data();
+        for(int i = 0; i < count; ++i){
+            if(!isSleeping[i]){
+                acc[i] += difAcc;
+            }
+        }
+    }
+
+    namespace {
+        //1ジョブで回す物体の数
+        const int bodyGrain = 256;
+    }
+
+    void BodyStore::Update(float delta, bool isAccelReset){
+        UpdateRange(0, GetCount(), delta, isAccelReset);
+    }
+
+    void BodyStore::Update(float delta, bool isAccelReset, JobSystem& jobs){
+        jobs.ParallelFor(0, GetCount(), bodyGrain, [&](int first, int last){
+            UpdateRange(first, last, delta, isAccelReset);
+        });
+    }
+
+    void BodyStore::UpdateRange(int first, int last, float delta, bool isAccelReset){
+        const Vector3* pos = position.data();
+        const Vector3* vel = velocity.data();
+        Vector3* acc = acceleration.data();
+        Vector3* movedPos = prePos.data();
+        Vector3* movedVel = preVel.data();
+        const char* isSleeping = sleeping.data();
+        float halfDeltaSq = 0.5f * delta * delta;
+        for(int i = first; i < last; ++i){
+            if(isSleeping[i]){
+                continue;
+            }
+            movedPos[i] = pos[i] + vel[i] * delta + acc[i] * halfDeltaSq;
+            movedVel[i] = vel[i] + acc[i] * delta;
+        }
+        if(isAccelReset){
+            for(int i = first; i < last; ++i){
+                acc[i] = Vector3();
+            }
+        }
+    }
+
+    void BodyStore::Fix(){
+        FixRange(0, GetCount());
+    }
+
+    void BodyStore::Fix(JobSystem& jobs){
+        jobs.ParallelFor(0, GetCount(), bodyGrain, [&](int first, int last){
+            FixRange(first, last);
+        });
+    }
+
+    void BodyStore::FixRange(int first, int last){
+        float maxVelocity = Physics::GetMaxVelocity();
+        Vector3* pos = position.data();
+        Vector3* vel = velocity.data();
+        const Vector3* movedPos = prePos.data();
+        const Vector3* movedVel = preVel.data();
+        const char* isSleeping = sleeping.data();
+        for(int i = first; i < last; ++i){
+            if(isSleeping[i]){
+                continue;
+            }
+            pos[i] = movedPos[i];
+            //Physics::Fixと同じく正の方向だけ制限する
+            vel[i].x = movedVel[i].x > maxVelocity ? maxVelocity : movedVel[i].x;
+            vel[i].y = movedVel[i].y > maxVelocity ? maxVelocity : movedVel[i].y;
+            vel[i].z = movedVel[i].z > maxVelocity ? maxVelocity : movedVel[i].z;
+        }
+    }
+
+    void BodyStore::Load(BodyHandle handle, Physics& phys) const {
+        int dense = slots[handle.index].dense;
+        phys.SetPosition(position[dense], false);
+        phys.SetVelocity(velocity[dense]);
+        phys.SetAcceleration(acceleration[dense]);
+        phys.SetPrePos(prePos[dense]);
+        phys.SetPreVel(preVel[dense]);
+        phys.SetMass(mass[dense]);
+    }
+
+    void BodyStore::Save(BodyHandle handle, const Physics& phys){
+        int dense = slots[handle.index].dense;
+        prePos[dense] = phys.GetPrePos();
+        preVel[dense] = phys.GetPreVel();
+    }
+}// namespace myTools
@@ -0,0 +1,137 @@
+//
+//  BodyStore.h
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/26.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#ifndef BodyStore_h
+#define BodyStore_h
+
+#include "Vector.h"
+#include <vector>
+
+namespace myTools {
+
+    class Physics;
+    class JobSystem;
+
+    //消された物体を指していないか generation で確かめる
+    struct BodyHandle {
+        int index = -1;
+        int generation = 0;
+    };
+
+    /**
+     *  @tips   Rigid body state stored as one array per field (SoA).
+     *          The arrays are packed, so Update / Fix are plain loops from the front.
+     *          Bodies are addressed by BodyHandle, which stays valid when Destroy reorders the arrays
+     */
+    class BodyStore {
+    public:
+        BodyHandle Create(const Vector3& position, float mass = 1.0f);
+        /**
+         *  @tips   Create a body with the position, velocity, acceleration and mass of phys
+         */
+        BodyHandle Create(const Physics& phys);
+        void Destroy(BodyHandle handle);
+        bool IsValid(BodyHandle handle) const;
+        void Reserve(int count);
+
+        int GetCount() const {
+            return (int)position.size();
+        }
+        //配列の添字. 削除すると変わるのでフレームをまたいで持たないこと
+        int GetIndex(BodyHandle handle) const {
+            return slots[handle.index].dense;
+        }
+
+        Vector3& Position(BodyHandle handle){
+            return position[GetIndex(handle)];
+        }
+        Vector3& Velocity(BodyHandle handle){
+            return velocity[GetIndex(handle)];
+        }
+        Vector3& Acceleration(BodyHandle handle){
+            return acceleration[GetIndex(handle)];
+        }
+        Vector3& PrePos(BodyHandle handle){
+            return prePos[GetIndex(handle)];
+        }
+        Vector3& PreVel(BodyHandle handle){
+            return preVel[GetIndex(handle)];
+        }
+        float GetMass(BodyHandle handle) const {
+            return mass[GetIndex(handle)];
+        }
+        void SetMass(BodyHandle handle, float mass);
+
+        /**
+         *  @tips   Sleeping bodies are skipped by AddAcceleration, Update and Fix.
+         *          Putting a body to sleep stops it (velocity and acceleration become 0).
+         */
+        void SetSleeping(BodyHandle handle, bool isSleeping);
+        bool IsSleeping(BodyHandle handle) const {
+            return sleeping[GetIndex(handle)] != 0;
+        }
+        //全物体の位置. 添字は GetIndex
+        const std::vector<Vector3>& GetPositions() const {
+            return position;
+        }
+
+        /**
+         *  @tips   Add the same acceleration to every body (gravity etc.)
+         */
+        void AddAcceleration(const Vector3& difAcc);
+
+        /**
+         *  @tips   Same as Physics::Update for every body that is not sleeping
+         */
+        void Update(float delta, bool isAccelReset);
+        //物体ごとに独立なので範囲に分けてジョブで回す(結果は上と同じ)
+        void Update(float delta, bool isAccelReset, JobSystem& jobs);
+
+        /**
+         *  @tips   Same as Physics::Fix for every body that is not sleeping
+         */
+        void Fix();
+        void Fix(JobSystem& jobs);
+
+        /**
+         *  @tips   Copy the state of the body into phys so the narrow phase can use it.
+         *          Fixes and restrict vectors in phys are not changed.
+         */
+        void Load(BodyHandle handle, Physics& phys) const;
+        /**
+         *  @tips   Copy back prePos / preVel after the narrow phase has fixed them
+         */
+        void Save(BodyHandle handle, const Physics& phys);
+
+    private:
+        void UpdateRange(int first, int last, float delta, bool isAccelReset);
+        void FixRange(int first, int last);
+
+        struct Slot {
+            //空きスロットのときは次の空きスロット
+            int dense = -1;
+            int generation = 0;
+        };
+
+        std::vector<Slot> slots;
+        int freeSlot = -1;
+
+        std::vector<Vector3> position;
+        std::vector<Vector3> velocity;
+        std::vector<Vector3> acceleration;
+        std::vector<Vector3> prePos;
+        std::vector<Vector3> preVel;
+        std::vector<float> mass;
+        std::vector<float> massRate;
+        std::vector<char> sleeping;
+        //配列の添字 -> スロット
+        std::vector<int> denseToSlot;
+    };
+}// namespace myTools
+
+#endif /* BodyStore_h */
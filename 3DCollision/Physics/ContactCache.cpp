@@ -0,0 +1,189 @@
+//
+//  ContactCache.cpp
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/02/05.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#include "ContactCache.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+
+namespace myTools {
+
+    namespace {
+        //平行とみなす sin^2
+        const float ParallelSinSq = 1.0e-3f;
+
+        //2点の間の接触点を作る
+        void SetPoint(const Vector3& lhsPos, const Vector3& rhsPos, float radiusSum, ContactPoint& point){
+            Vector3 toRhs = rhsPos - lhsPos;
+            float distance = toRhs.Length();
+            point.position = (lhsPos + rhsPos) * 0.5f;
+            point.separation = distance - radiusSum;
+            point.impulse = 0.0f;
+            //中心が重なっているときは向きが決まらないので上に押し出す
+            point.normal = distance > MT_EPSILON ? toRhs * (1.0f / distance) : Vector3(0.0f, 1.0f, 0.0f);
+        }
+
+        void SetPositions(const Vector3& lhsPos, const Vector3& rhsPos, ContactManifold& manifold){
+            manifold.lhsPos = lhsPos;
+            manifold.rhsPos = rhsPos;
+            manifold.baseRelPos = rhsPos - lhsPos;
+        }
+    }
+
+    float ContactManifold::GetMinSeparation() const {
+        float separation = points[0].separation;
+        for(int i = 1; i < pointCount; ++i){
+            separation = std::min(separation, points[i].separation);
+        }
+        return separation;
+    }
+
+    void CulcManifold(const MoveCollData<SphereCollision>& lhs, const MoveCollData<SphereCollision>& rhs,
+                      ContactManifold& manifold){
+        Vector3 lhsPos = lhs.phys.GetPosition();
+        Vector3 rhsPos = rhs.phys.GetPosition();
+        SetPoint(lhsPos, rhsPos, lhs.collision.radius + rhs.collision.radius, manifold.points[0]);
+        manifold.pointCount = 1;
+        SetPositions(lhsPos, rhsPos, manifold);
+    }
+
+    void CulcManifold(const MoveCollData<SphereCollision>& lhs, const MoveCollData<CapsuleCollision>& rhs,
+                      ContactManifold& manifold){
+        Vector3 center = lhs.phys.GetPosition();
+        Segment segment(rhs.phys.GetPosition(), rhs.collision.s.v);
+        float t;
+        Vector3 nearest;
+        SupPointSegmentDistSq(center, segment, t, nearest);
+        SetPoint(center, nearest, lhs.collision.radius + rhs.collision.radius, manifold.points[0]);
+        manifold.pointCount = 1;
+        SetPositions(center, rhs.phys.GetPosition(), manifold);
+    }
+
+    void CulcManifold(const MoveCollData<CapsuleCollision>& lhs, const MoveCollData<CapsuleCollision>& rhs,
+                      ContactManifold& manifold){
+        Segment lhsSegment(lhs.phys.GetPosition(), lhs.collision.s.v);
+        Segment rhsSegment(rhs.phys.GetPosition(), rhs.collision.s.v);
+        float radiusSum = lhs.collision.radius + rhs.collision.radius;
+        SetPositions(lhsSegment.p, rhsSegment.p, manifold);
+
+        //平行に並んでいるときは重なっている範囲の両端を接触点にする
+        float lhsLenSq = lhsSegment.v.LengthSq();
+        float rhsLenSq = rhsSegment.v.LengthSq();
+        if(lhsLenSq > MT_EPSILON && rhsLenSq > MT_EPSILON &&
+           cross(lhsSegment.v, rhsSegment.v).LengthSq() < ParallelSinSq * lhsLenSq * rhsLenSq){
+            float t0 = dot(rhsSegment.p - lhsSegment.p, lhsSegment.v) / lhsLenSq;
+            float t1 = dot(rhsSegment.GetEndPoint() - lhsSegment.p, lhsSegment.v) / lhsLenSq;
+            float first = std::max(std::min(t0, t1), 0.0f);
+            float last = std::min(std::max(t0, t1), 1.0f);
+            if((last - first) * (last - first) * lhsLenSq > MT_EPSILON){
+                float ts[2] = {first, last};
+                for(int i = 0; i < 2; ++i){
+                    Vector3 lhsPos = lhsSegment.p + lhsSegment.v * ts[i];
+                    float t;
+                    Vector3 rhsPos;
+                    SupPointSegmentDistSq(lhsPos, rhsSegment, t, rhsPos);
+                    SetPoint(lhsPos, rhsPos, radiusSum, manifold.points[i]);
+                }
+                manifold.pointCount = 2;
+                return;
+            }
+        }
+
+        float t1, t2;
+        Vector3 lhsNearest, rhsNearest;
+        SupSegmentSegmentDist(lhsSegment, rhsSegment, t1, t2, lhsNearest, rhsNearest);
+        SetPoint(lhsNearest, rhsNearest, radiusSum, manifold.points[0]);
+        manifold.pointCount = 1;
+    }
+
+    size_t ContactCache::PairKeyHash::operator()(const PairKey& key) const {
+        uint64_t index = ((uint64_t)(uint32_t)key.lhs.index << 32) | (uint32_t)key.rhs.index;
+        uint64_t generation = ((uint64_t)(uint32_t)key.lhs.generation << 32) | (uint32_t)key.rhs.generation;
+        return std::hash<uint64_t>()(index ^ (generation * 0x9E3779B97F4A7C15ull));
+    }
+
+    ContactManifold& ContactCache::Get(BodyHandle lhs, BodyHandle rhs){
+        PairKey key;
+        key.lhs = lhs;
+        key.rhs = rhs;
+        //emplace は見つかったときも作ってしまうので先に探す
+        auto itr = manifolds.find(key);
+        if(itr == manifolds.end()){
+            itr = manifolds.emplace(key, ContactManifold()).first;
+        }
+        ContactManifold& manifold = itr->second;
+        //途切れていたペアの古い力積は使わない
+        if(manifold.lastStep != step - 1){
+            manifold.pointCount = 0;
+        }
+        manifold.lastStep = step;
+        return manifold;
+    }
+
+    void ContactCache::EndStep(){
+        for(auto itr = manifolds.begin(); itr != manifolds.end();){
+            if(step - itr->second.lastStep > maxAge){
+                itr = manifolds.erase(itr);
+            }
+            else {
+                ++itr;
+            }
+        }
+    }
+
+    bool ContactCache::CanReuse(const ContactManifold& manifold, const Vector3& lhsPos, const Vector3& rhsPos) const {
+        if(manifold.pointCount == 0){
+            return false;
+        }
+        Vector3 motion = (rhsPos - lhsPos) - manifold.baseRelPos;
+        return motion.LengthSq() < motionThreshold * motionThreshold;
+    }
+
+    void ContactCache::Reuse(ContactManifold& manifold, const Vector3& lhsPos, const Vector3& rhsPos) const {
+        //相対的に動いた分だけ距離を変える(ずれが小さいので向きはそのまま)
+        Vector3 relMotion = (rhsPos - lhsPos) - (manifold.rhsPos - manifold.lhsPos);
+        Vector3 motion = ((lhsPos - manifold.lhsPos) + (rhsPos - manifold.rhsPos)) * 0.5f;
+        for(int i = 0; i < manifold.pointCount; ++i){
+            ContactPoint& point = manifold.points[i];
+            point.separation += dot(relMotion, point.normal);
+            point.position += motion;
+        }
+        manifold.lhsPos = lhsPos;
+        manifold.rhsPos = rhsPos;
+    }
+
+    void ContactCache::Update(ContactManifold& manifold, const ContactManifold& fresh) const {
+        float matchDistanceSq = matchDistance * matchDistance;
+        bool isMatched[ContactManifold::MaxPoints] = {};
+        ContactPoint points[ContactManifold::MaxPoints];
+        for(int i = 0; i < fresh.pointCount; ++i){
+            points[i] = fresh.points[i];
+            //一番近い古い点の力積を引き継ぐ(1つの点は1回だけ)
+            int nearest = -1;
+            float nearestDistSq = matchDistanceSq;
+            for(int j = 0; j < manifold.pointCount; ++j){
+                float distSq = (manifold.points[j].position - fresh.points[i].position).LengthSq();
+                if(!isMatched[j] && distSq <= nearestDistSq){
+                    nearest = j;
+                    nearestDistSq = distSq;
+                }
+            }
+            if(nearest >= 0){
+                isMatched[nearest] = true;
+                points[i].impulse = manifold.points[nearest].impulse;
+            }
+        }
+        for(int i = 0; i < fresh.pointCount; ++i){
+            manifold.points[i] = points[i];
+        }
+        manifold.pointCount = fresh.pointCount;
+        manifold.lhsPos = fresh.lhsPos;
+        manifold.rhsPos = fresh.rhsPos;
+        manifold.baseRelPos = fresh.baseRelPos;
+    }
+}// namespace myTools
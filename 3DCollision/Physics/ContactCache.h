@@ -0,0 +1,147 @@
+//
+//  ContactCache.h
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/02/05.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#ifndef ContactCache_h
+#define ContactCache_h
+
+#include "Physics.h"
+#include "BodyStore.h"
+#include <cstddef>
+#include <unordered_map>
+
+namespace myTools {
+
+    /**
+     *  @tips   Contact point. normal is a unit vector from lhs to rhs.
+     *          separation is between the surfaces (negative when overlapping). impulse is what the solver accumulated
+     */
+    struct ContactPoint {
+        Vector3 position;
+        Vector3 normal;
+        float separation = 0.0f;
+        float impulse = 0.0f;
+    };
+
+    /**
+     *  @tips   Contact points of a body pair (up to MaxPoints), kept across frames.
+     *          lhs / rhs are the body indices passed to the solver
+     */
+    struct ContactManifold {
+        static const int MaxPoints = 4;
+
+        int lhs = -1;
+        int rhs = -1;
+        //このステップで解くか(一番近い点が margin より近い)
+        bool hit = false;
+        int pointCount = 0;
+        ContactPoint points[MaxPoints];
+        //点を求めた時の位置と, 最後に更新した時の位置
+        Vector3 lhsPos;
+        Vector3 rhsPos;
+        Vector3 baseRelPos;
+        //最後にペアとして見つかったステップ
+        int lastStep = 0;
+
+        float GetMinSeparation() const;
+    };
+
+    /**
+     *  @tips   Contact points between the shapes at their position before moving (phys.GetPosition()).
+     *          Points are made however far apart the shapes are. Impulses start at 0.
+     *          Nearly parallel capsules give two points at the ends of their overlap.
+     */
+    void CulcManifold(const MoveCollData<SphereCollision>& lhs, const MoveCollData<SphereCollision>& rhs,
+                      ContactManifold& manifold);
+    void CulcManifold(const MoveCollData<SphereCollision>& lhs, const MoveCollData<CapsuleCollision>& rhs,
+                      ContactManifold& manifold);
+    void CulcManifold(const MoveCollData<CapsuleCollision>& lhs, const MoveCollData<CapsuleCollision>& rhs,
+                      ContactManifold& manifold);
+
+    /**
+     *  @tips   Keeps a ContactManifold per body pair (pair of BodyHandle).
+     *          It carries the last step's impulses over to the new points (warm starting)
+     *          and reuses the points of pairs that have barely moved.
+     *          Pairs not found for a while are dropped
+     *
+     *          BeginStep -> (one thread) Get -> (in parallel) CanReuse ? Reuse : Update -> EndStep
+     */
+    class ContactCache {
+    public:
+        //これだけのステップの間ペアにならなければ捨てる
+        void SetMaxAge(int age){
+            maxAge = age > 0 ? age : 0;
+        }
+        //点を求めてから相対位置がこれ以上ずれたら計算し直す
+        void SetMotionThreshold(float threshold){
+            motionThreshold = threshold;
+        }
+        float GetMotionThreshold() const {
+            return motionThreshold;
+        }
+        //前の点の力積を引き継ぐ距離
+        void SetMatchDistance(float distance){
+            matchDistance = distance;
+        }
+
+        void BeginStep(){
+            ++step;
+        }
+        /**
+         *  @tips   Find or add the manifold of the pair. The pair is lhs / rhs in this order.
+         *          A pair that was not found in the last step loses its old points.
+         *          Not thread safe. The reference stays valid until EndStep.
+         */
+        ContactManifold& Get(BodyHandle lhs, BodyHandle rhs);
+        /**
+         *  @tips   Remove manifolds not found for more than maxAge steps
+         */
+        void EndStep();
+        void Clear(){
+            manifolds.clear();
+        }
+
+        /**
+         *  @tips   True when the old points can be used at the new positions
+         */
+        bool CanReuse(const ContactManifold& manifold, const Vector3& lhsPos, const Vector3& rhsPos) const;
+        /**
+         *  @tips   Move the old points by the relative motion since the last update
+         */
+        void Reuse(ContactManifold& manifold, const Vector3& lhsPos, const Vector3& rhsPos) const;
+        /**
+         *  @tips   Replace the points with fresh ones from CulcManifold.
+         *          Each fresh point takes the impulse of the nearest old point within matchDistance.
+         */
+        void Update(ContactManifold& manifold, const ContactManifold& fresh) const;
+
+        int GetCount() const {
+            return (int)manifolds.size();
+        }
+
+    private:
+        struct PairKey {
+            BodyHandle lhs;
+            BodyHandle rhs;
+            bool operator==(const PairKey& key) const {
+                return lhs.index == key.lhs.index && lhs.generation == key.lhs.generation &&
+                       rhs.index == key.rhs.index && rhs.generation == key.rhs.generation;
+            }
+        };
+        struct PairKeyHash {
+            size_t operator()(const PairKey& key) const;
+        };
+
+        int maxAge = 8;
+        float motionThreshold = 0.01f;
+        float matchDistance = 0.1f;
+        int step = 0;
+        std::unordered_map<PairKey, ContactManifold, PairKeyHash> manifolds;
+    };
+}// namespace myTools
+
+#endif /* ContactCache_h */
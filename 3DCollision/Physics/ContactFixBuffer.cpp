@@ -0,0 +1,55 @@
+//
+//  ContactFixBuffer.cpp
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/30.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#include "ContactFixBuffer.h"
+
+namespace myTools {
+
+    void ContactFixBuffer::Reset(int bodyCount, int pairCount){
+        this->bodyCount = bodyCount;
+        fixes.resize(pairCount);
+        bodies.resize(pairCount);
+    }
+
+    void ContactFixBuffer::BuildBodyLists(){
+        int pairCount = (int)fixes.size();
+        bodyStart.assign(bodyCount + 1, 0);
+        for(int i = 0; i < pairCount; ++i){
+            if(!fixes[i].hit){
+                continue;
+            }
+            ++bodyStart[bodies[i].first + 1];
+            ++bodyStart[bodies[i].second + 1];
+        }
+        for(int i = 0; i < bodyCount; ++i){
+            bodyStart[i + 1] += bodyStart[i];
+        }
+        //ペアの番号順に詰めるので物体ごとの一覧も番号順になる
+        entries.resize(bodyStart[bodyCount]);
+        bodyCursor.assign(bodyStart.begin(), bodyStart.end() - 1);
+        for(int i = 0; i < pairCount; ++i){
+            if(!fixes[i].hit){
+                continue;
+            }
+            entries[bodyCursor[bodies[i].first]++] = i * 2;
+            entries[bodyCursor[bodies[i].second]++] = i * 2 + 1;
+        }
+    }
+
+    void ContactFixBuffer::Apply(int body, Physics& phys) const {
+        for(int i = bodyStart[body]; i < bodyStart[body + 1]; ++i){
+            const ContactFix& fix = fixes[entries[i] / 2];
+            if(entries[i] % 2 == 0){
+                phys.AddFix(fix.lhsPosFix, fix.lhsVelFix);
+            }
+            else {
+                phys.AddFix(fix.rhsPosFix, fix.rhsVelFix);
+            }
+        }
+    }
+}// namespace myTools
@@ -0,0 +1,63 @@
+//
+//  ContactFixBuffer.h
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/30.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#ifndef ContactFixBuffer_h
+#define ContactFixBuffer_h
+
+#include "Physics.h"
+#include <vector>
+
+namespace myTools {
+
+    /**
+     *  @tips   Keeps one fix (ContactFix) per pair and adds them up per body afterwards.
+     *          CulcFix writes each pair to its own record, so it can run in parallel.
+     *          Each body always adds its fixes in pair order, so the result is
+     *          bit-identical whichever thread handles a pair and in whatever order
+     *
+     *          Reset -> (in parallel) GetFix / SetBodies -> BuildBodyLists -> (in parallel) Apply
+     */
+    class ContactFixBuffer {
+    public:
+        /**
+         *  @tips   Prepare records for pairCount pairs between bodyCount bodies. Capacity is reused.
+         */
+        void Reset(int bodyCount, int pairCount);
+
+        ContactFix& GetFix(int pair){
+            return fixes[pair];
+        }
+        //ペアの lhs / rhs がどの物体か(CulcFix に渡した順)
+        void SetBodies(int pair, int lhsBody, int rhsBody){
+            bodies[pair].first = lhsBody;
+            bodies[pair].second = rhsBody;
+        }
+
+        /**
+         *  @tips   Build the per-body lists in pair order. Call on one thread after every SetBodies.
+         */
+        void BuildBodyLists();
+
+        /**
+         *  @tips   AddFix every fix of body to phys in pair order. Different bodies may run in parallel.
+         */
+        void Apply(int body, Physics& phys) const;
+
+    private:
+        std::vector<ContactFix> fixes;
+        std::vector<std::pair<int,int>> bodies;
+        //物体ごとの一覧. 値は pair * 2 + (0 : lhs, 1 : rhs)
+        //body の分は entries[bodyStart[body]] ～ entries[bodyStart[body + 1] - 1]
+        std::vector<int> bodyStart;
+        std::vector<int> bodyCursor;
+        std::vector<int> entries;
+        int bodyCount = 0;
+    };
+}// namespace myTools
+
+#endif /* ContactFixBuffer_h */
@@ -0,0 +1,88 @@
+//
+//  ContactSolver.cpp
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/02/04.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#include "ContactSolver.h"
+#include <algorithm>
+
+namespace myTools {
+
+    void ContactSolver::Begin(int bodyCount){
+        velocities.assign(bodyCount, Vector3());
+        massRates.assign(bodyCount, 0.0f);
+        contacts.clear();
+        constraints.clear();
+    }
+
+    void ContactSolver::SetBody(int body, const Vector3& velocity, float massRate){
+        velocities[body] = velocity;
+        massRates[body] = massRate;
+    }
+
+    void ContactSolver::AddContact(const Contact& contact){
+        contacts.push_back(contact);
+    }
+
+    void ContactSolver::ApplyImpulse(const Contact& contact, float impulse){
+        Vector3 p = contact.normal * impulse;
+        velocities[contact.lhs] -= p * massRates[contact.lhs];
+        velocities[contact.rhs] += p * massRates[contact.rhs];
+    }
+
+    void ContactSolver::Solve(float delta){
+        float deltaRate = 1.0f / delta;
+        constraints.resize(contacts.size());
+        for(int i = 0; i < contacts.size(); ++i){
+            const Contact& contact = contacts[i];
+            Constraint& constraint = constraints[i];
+            float massRateSum = massRates[contact.lhs] + massRates[contact.rhs];
+            constraint.massEff = massRateSum > 0.0f ? 1.0f / massRateSum : 0.0f;
+            constraint.impulse = 0.0f;
+
+            float normalVel = dot(velocities[contact.rhs] - velocities[contact.lhs], contact.normal);
+            if(contact.separation > 0.0f){
+                //離れている分は近づいてよい
+                constraint.bias = -contact.separation * deltaRate;
+            }
+            else {
+                //めり込みは slop を残して少しずつ戻す
+                constraint.bias = baumgarte * std::max(-contact.separation - slop, 0.0f) * deltaRate;
+            }
+            bool isTouching = contact.separation <= slop;
+            if(isTouching && normalVel < -restitutionVelocity){
+                constraint.bias = std::max(constraint.bias, -restitution * normalVel);
+            }
+        }
+
+        //触れ続けている接触だけ前のフレームの力積から始める
+        //(跳ね返りの速さは力積を与える前の速度で決めるので, 上とは別に回す)
+        if(isWarmStarting){
+            for(int i = 0; i < contacts.size(); ++i){
+                const Contact& contact = contacts[i];
+                if(contact.separation > slop || contact.impulse <= 0.0f){
+                    continue;
+                }
+                constraints[i].impulse = contact.impulse;
+                ApplyImpulse(contact, contact.impulse);
+            }
+        }
+
+        for(int iteration = 0; iteration < iterationCount; ++iteration){
+            for(int i = 0; i < contacts.size(); ++i){
+                const Contact& contact = contacts[i];
+                Constraint& constraint = constraints[i];
+                float normalVel = dot(velocities[contact.rhs] - velocities[contact.lhs], contact.normal);
+                float impulse = constraint.massEff * (constraint.bias - normalVel);
+                //合計で引っ張る向きにはならないように切る
+                float total = std::max(constraint.impulse + impulse, 0.0f);
+                impulse = total - constraint.impulse;
+                constraint.impulse = total;
+                ApplyImpulse(contact, impulse);
+            }
+        }
+    }
+}// namespace myTools
@@ -0,0 +1,125 @@
+//
+//  ContactSolver.h
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/02/04.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#ifndef ContactSolver_h
+#define ContactSolver_h
+
+#include "Physics.h"
+#include <vector>
+
+namespace myTools {
+
+    /**
+     *  @tips   Contact point between two bodies. normal is a unit vector from lhs to rhs.
+     *          separation is between the surfaces before moving (negative when overlapping).
+     *          impulse is the last step's impulse for warm starting (0 if none)
+     */
+    struct Contact {
+        int lhs = -1;
+        int rhs = -1;
+        Vector3 normal;
+        float separation = 0.0f;
+        float impulse = 0.0f;
+    };
+
+    /**
+     *  @tips   Sequential impulse contact solver (translation only, bodies do not rotate).
+     *          Normal impulses are accumulated per contact and clamped so the total never pulls.
+     *          Iteration starts from Contact::impulse, the last step's impulse (warm starting).
+     *          Separated contacts may close their gap within one step (speculative contact),
+     *          so fast bodies do not tunnel.
+     *
+     *          Begin -> SetBody -> AddContact -> Solve -> GetVelocity
+     */
+    class ContactSolver {
+    public:
+        void SetIterationCount(int count){
+            iterationCount = count > 0 ? count : 1;
+        }
+        int GetIterationCount() const {
+            return iterationCount;
+        }
+        //反発係数
+        void SetRestitution(float restitution){
+            this->restitution = restitution;
+        }
+        //これより遅くぶつかったときは跳ね返らない
+        void SetRestitutionVelocity(float velocity){
+            restitutionVelocity = velocity;
+        }
+        //めり込みを1ステップで戻す割合(0 ～ 1)
+        void SetBaumgarte(float baumgarte){
+            this->baumgarte = baumgarte;
+        }
+        //これだけはめり込んだままにしておく(触れている接触を保つため)
+        void SetSlop(float slop){
+            this->slop = slop;
+        }
+        float GetSlop() const {
+            return slop;
+        }
+        void SetWarmStarting(bool isEnabled){
+            isWarmStarting = isEnabled;
+        }
+
+        /**
+         *  @tips   Start a step with bodyCount bodies. Every body starts with no velocity change.
+         */
+        void Begin(int bodyCount);
+        /**
+         *  @tips   massRate 0 makes the body immovable (sleeping bodies etc.)
+         */
+        void SetBody(int body, const Vector3& velocity, float massRate);
+        void AddContact(const Contact& contact);
+
+        /**
+         *  @tips   Solve every contact added since Begin. Contacts are solved in the order added,
+         *          so the result does not depend on the thread count.
+         */
+        void Solve(float delta);
+
+        Vector3 GetVelocity(int body) const {
+            return velocities[body];
+        }
+        int GetContactCount() const {
+            return (int)contacts.size();
+        }
+        //積み上げた力積. 次のステップの Contact::impulse に渡す
+        float GetImpulse(int contact) const {
+            return constraints[contact].impulse;
+        }
+        //このステップで力積が働いたか
+        bool IsPushed(int contact) const {
+            return constraints[contact].impulse > 0.0f;
+        }
+
+    private:
+        struct Constraint {
+            float massEff;
+            //これ以上の速さで離れる(負なら近づいてよい)
+            float bias;
+            float impulse;
+        };
+
+        void ApplyImpulse(const Contact& contact, float impulse);
+
+        int iterationCount = 8;
+        float restitution = 0.1f;
+        float restitutionVelocity = 1.0f;
+        float baumgarte = 0.2f;
+        float slop = 0.01f;
+        bool isWarmStarting = true;
+
+        std::vector<Vector3> velocities;
+        std::vector<float> massRates;
+        std::vector<Contact> contacts;
+        std::vector<Constraint> constraints;
+    };
+}// namespace myTools
+
+#endif /* ContactSolver_h */
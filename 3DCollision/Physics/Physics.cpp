@@ -8,6 +8,7 @@
 
 #include "Physics.h"
 #include "Quaternion.h"
+#include "ConvexCollision.h"
 #include <math.h>
 namespace myTools{
     float Physics::maxVelocity = 1000.0f;
@@ -98,19 +99,11 @@ namespace myTools{
     }
     
     void Physics::PreFix(){
-        Vector3 posFixVec;
+        //修正量の長さの2乗で重み付けした平均
         if(posSum != 0){
-            float posSumRate = 1 / posSum;
-            for(auto& fix : posFixes){
-                posFixVec += fix * (fix.LengthSq()) * posSumRate;
-            }
-        }
-        prePos += posFixVec;
-        
-        Vector3 velFixVec;
-        for(auto& fix : velFixes){
-            preVel += fix;
+            prePos += posFixSum * (1 / posSum);
         }
+        preVel += velFixSum;
         restrictVectores.clear();
 //        auto itr = restrictVectores.begin();
 //        while (itr != restrictVectores.end()) {
@@ -142,6 +135,45 @@ namespace myTools{
         return (phys.GetPrePos() - phys.GetPosition());
     }
     
+    //静的判定は移動前後の位置しか見ないのでそれだけ写す(修正量のvectorをコピーしない)
+    static Physics SupMovePhys(const Physics& phys){
+        Physics ret;
+        ret.SetPosition(phys.GetPosition(), false);
+        ret.SetPrePos(phys.GetPrePos());
+        return ret;
+    }
+    
+    //線分を移動させたときに通る範囲 + 半径
+    void SupSweptAABB(const Vector3& pos, const Vector3& prePos, const Vector3& length, float radius, AABBCollision& aabb){
+        Vector3 end = pos + length;
+        Vector3 preEnd = prePos + length;
+        for(int i = 0; i < 3; ++i){
+            aabb.min[i] = fminf(fminf(pos[i], end[i]), fminf(prePos[i], preEnd[i])) - radius;
+            aabb.max[i] = fmaxf(fmaxf(pos[i], end[i]), fmaxf(prePos[i], preEnd[i])) + radius;
+        }
+    }
+    
+    void CulcAABB(MoveCollData<SphereCollision>& sphere){
+        SupSweptAABB(sphere.phys.GetPosition(), sphere.phys.GetPrePos(), Vector3(), sphere.collision.radius, sphere.aabb);
+    }
+    void CulcAABB(MoveCollData<CylinderCollision>& cylinder){
+        SupSweptAABB(cylinder.phys.GetPosition(), cylinder.phys.GetPrePos(), cylinder.collision.line.v, cylinder.collision.radius, cylinder.aabb);
+    }
+    void CulcAABB(MoveCollData<CapsuleCollision>& capsule){
+        SupSweptAABB(capsule.phys.GetPosition(), capsule.phys.GetPrePos(), capsule.collision.s.v, capsule.collision.radius, capsule.aabb);
+    }
+    void CulcAABB(MoveCollData<CubeCollision>& cube){
+        //回転はしないので包む箱の大きさは移動前後で同じ
+        AABBCollision bound = CastToAABB(cube.collision);
+        Vector3 half = (bound.max - bound.min) * 0.5f;
+        Vector3 pos = cube.phys.GetPosition();
+        Vector3 prePos = cube.phys.GetPrePos();
+        for(int i = 0; i < 3; ++i){
+            cube.aabb.min[i] = fminf(pos[i], prePos[i]) - half[i];
+            cube.aabb.max[i] = fmaxf(pos[i], prePos[i]) + half[i];
+        }
+    }
+    
     //Sphere and Sphere HitTime
     HitData MoveCollision(const MoveCollData<SphereCollision>& sphere1,
                           const MoveCollData<SphereCollision>& sphere2){
@@ -1352,7 +1384,9 @@ namespace myTools{
         Vector3 sphereVel = sphereMovedPos - spherePos;
         CapsuleCollision sweepSphere(sphere.collision.radius, spherePos,sphereVel);
         
-        std::vector<Segment> sides = square.GetSides();
+        Segment sides[4];
+        
+        square.GetSides(sides);
         HitData buf;
         if(CollisionReturnFlag(sweepSphere, sides[0])){
             ret = StaticCollision(sphere, sides[0]);
@@ -1405,7 +1439,8 @@ namespace myTools{
             Vector3 cylVel = CulcVel(cylinder.phys);
             Vector3 castLinePos = CastToPlane(squPlane, cylLine.p + cylVel * ret.time);
             Line castLine(castLinePos, cylLine.v);
-            std::vector<Segment> sides = square.GetSides();
+            Segment sides[4];
+            square.GetSides(sides);
             float t[2];
             Vector3 buf;
             Vector3 pos[2];
@@ -1429,8 +1464,9 @@ namespace myTools{
                 Line onHitLine(cylLine.p + cylVel * ret.time,cylLine.v);
                 float tmp;
                 float minDist = 100000.0f;
-                const Vector3* hitVert[2];
-                const std::vector<Point> verts = square.GetPoints();
+                const Point* verts = square.p;
+                //距離が全部 minDist を超えても(NaN でも)1つめの頂点で返す
+                const Vector3* hitVert[2] = { &verts[0], nullptr };
                 for(int i = 0; i < 4; ++i){
                     tmp = Distance(verts[i], onHitLine);
                     if(tmp <= minDist){
@@ -1457,7 +1493,8 @@ namespace myTools{
             if(CollisionReturnFlag(square, ret.hitPos)){
                 return ret;
             }
-            std::vector<Segment> sides = square.GetSides();
+            Segment sides[4];
+            square.GetSides(sides);
             //一番近い線分を探す
             int index = 0;
             float dist;
@@ -1486,6 +1523,7 @@ namespace myTools{
         HitData* ret = nullptr;
         float radius = capsule.collision.radius;
         Vector3 capVel = CulcVel(capsule.phys);
+        const Physics capPhys = SupMovePhys(capsule.phys);
         Vector3 capEndPos = capsule.collision.s.p + capsule.collision.s.v;
         CapsuleCollision sweepStartSphere(radius,capsule.collision.s.p,capVel);
         CapsuleCollision sweepEndSphere(radius, capEndPos,capVel);
@@ -1495,7 +1533,7 @@ namespace myTools{
         auto CollEndPosSpheres = [&](HitData*& res){
             //端点の球との判定(ここから)
             if(CollisionReturnFlag(sweepStartSphere, square)){
-                sphereHitData[0] = StaticCollision(MoveCollData<myTools::SphereCollision>(SphereCollision(radius, capsule.collision.s.p),capsule.phys), square);
+                sphereHitData[0] = StaticCollision(MoveCollData<myTools::SphereCollision>(SphereCollision(radius, capsule.collision.s.p),capPhys), square);
             }
             if(CollisionReturnFlag(sweepEndSphere, square)){
                 Physics tmp;
@@ -1527,8 +1565,11 @@ namespace myTools{
         };
 
         
-        const std::vector<Segment>& sides = square.GetSides();
-        MoveCollData<CylinderCollision> capCylinder(CylinderCollision(radius, capsule.collision.s),capsule.phys);
+        Segment sides[4];
+
+        
+        square.GetSides(sides);
+        MoveCollData<CylinderCollision> capCylinder(CylinderCollision(radius, capsule.collision.s),capPhys);
         HitData cylHitdata = StaticCollision(capCylinder, square);
         if(!cylHitdata.hit){
             return cylHitdata;
@@ -1546,7 +1587,7 @@ namespace myTools{
                 //辺と当たっているのか頂点と当たっているのか調べる
                 //衝突時線との距離を測って一番近い点を探す
                 //近い点が２つあればその2点の線分との中点がカプセルのシリンダー内かどうか判定
-                const std::vector<Point>& verts = square.GetPoints();
+                const Point* verts = square.p;
                 float dist = 100000.0f;
                 float tmp;
                 const Point* hitPoints[2] = {nullptr, nullptr};
@@ -1645,7 +1686,7 @@ namespace myTools{
                         tmp.SetPosition(capEndPos,false);
                         tmp.SetPrePos(capEndPos + capVel);
                         HitData data[2] = {
-                            StaticCollision(MoveCollData<myTools::SphereCollision>(SphereCollision(capsule.collision.radius, capsule.collision.s.p),capsule.phys), square),
+                            StaticCollision(MoveCollData<myTools::SphereCollision>(SphereCollision(capsule.collision.radius, capsule.collision.s.p),capPhys), square),
                             StaticCollision(MoveCollData<SphereCollision>(SphereCollision(capsule.collision.radius, capEndPos),tmp), square),
                         };
                         if(data[0].hit){
@@ -1679,7 +1720,7 @@ namespace myTools{
         tmp.SetPosition(capEndPos,false);
         tmp.SetPrePos(capEndPos + capVel);
         HitData data[2] = {
-            StaticCollision(MoveCollData<myTools::SphereCollision>(SphereCollision(capsule.collision.radius, capsule.collision.s.p),capsule.phys), square),
+            StaticCollision(MoveCollData<myTools::SphereCollision>(SphereCollision(capsule.collision.radius, capsule.collision.s.p),capPhys), square),
             StaticCollision(MoveCollData<SphereCollision>(SphereCollision(capsule.collision.radius, capEndPos),tmp), square),
         };
         if(data[0].hit){
@@ -1744,7 +1785,7 @@ namespace myTools{
 //            else {
 //                //衝突時線との距離を測って一番近い点を探す
 //                //近い点が２つあればその2点の線分との中点がカプセルのシリンダーないかどうか判定
-//                const std::vector<Point>& verts = square.GetPoints();
+//                const Point* verts = square.p;
 //                float dist = 100000.0f;
 //                float tmp;
 //                const Point* hitPoints[2] = {nullptr, nullptr};
@@ -1825,15 +1866,8 @@ namespace myTools{
     
     HitData StaticCollision(const MoveCollData<SphereCollision>& sphere,
                             const AABBCollision& aabb){
-        std::vector<Point> verts = aabb.GetPoints();
-        SquareCollision squares[6] = {
-            SquareCollision(verts[0], verts[1], verts[2], verts[3],false),
-            SquareCollision(verts[3], verts[2], verts[6], verts[7],false),
-            SquareCollision(verts[7], verts[6], verts[5], verts[4],false),
-            SquareCollision(verts[4], verts[5], verts[1], verts[0],false),
-            SquareCollision(verts[4], verts[0], verts[3], verts[7],false),
-            SquareCollision(verts[1], verts[5], verts[6], verts[2],false),
-        };
+        SquareCollision squares[6];
+        aabb.GetSquares(squares);
         //すでに衝突しているとき
         if(CollisionReturnFlag(aabb, sphere.collision)){
             HitData ret;
@@ -1889,8 +1923,39 @@ namespace myTools{
         }
     }
     
+    /**
+     *  @tips   Moving convex shape against a static one (GJK / EPA). hitNormal points from staticShape to moving.
+     *          The search starts at startTime when they are known not to touch before it
+     */
+    HitData SupConvexStaticCollision(const ConvexShape& moving, const Vector3& vel, const ConvexShape& staticShape,
+                                     float startTime = 0.0f){
+        HitData ret;
+        ConvexShape start = moving;
+        start.offset += vel * startTime;
+        ConvexHitData data = ConvexCollision(start, staticShape);
+        //すでに衝突しているとき
+        if(data.hit){
+            ret.hit = true;
+            ret.time = startTime;
+            ret.hitNormal = -data.normal;
+            ret.hitPos = data.rhsPos;
+            ret.length = -data.distance;
+            return ret;
+        }
+        float t;
+        if(ConvexCast(start, vel * (1.0f - startTime), staticShape, t, data)){
+            ret.hit = true;
+            ret.time = startTime + t * (1.0f - startTime);
+            ret.hitNormal = -data.normal;
+            ret.hitPos = data.rhsPos;
+        }
+        return ret;
+    }
+    
     HitData StaticCollision(const MoveCollData<CylinderCollision>& cylinder,
-                            const AABBCollision& aabb);
+                            const AABBCollision& aabb){
+        return SupConvexStaticCollision(CastToConvex(cylinder.collision), CulcVel(cylinder.phys), CastToConvex(aabb));
+    }
     
     HitData StaticCollision(const MoveCollData<CapsuleCollision>& capsule,
                             const AABBCollision& aabb){
@@ -1899,15 +1964,8 @@ namespace myTools{
         Vector3 capEndPos = capPos + capsule.collision.s.v;
         Vector3 capVel = CulcVel(capsule.phys);
 
-        std::vector<Point> verts = aabb.GetPoints();
-        std::vector<SquareCollision> squares{
-            SquareCollision(verts[0], verts[1], verts[2], verts[3],false),
-            SquareCollision(verts[3], verts[2], verts[6], verts[7],false),
-            SquareCollision(verts[7], verts[6], verts[5], verts[4],false),
-            SquareCollision(verts[4], verts[5], verts[1], verts[0],false),
-            SquareCollision(verts[4], verts[0], verts[3], verts[7],false),
-            SquareCollision(verts[1], verts[5], verts[6], verts[2],false),
-        };
+        SquareCollision squares[6];
+        aabb.GetSquares(squares);
         
         PlaneCollision squPlane;
         float t;
@@ -2009,9 +2067,6 @@ namespace myTools{
         }
         return HitData();
     }
-    HitData StaticCollision(const MoveCollData<CapsuleCollision>& capsule,
-                            const DomeCollision& staticSphere);
-    
     HitData StaticCollision(const MoveCollData<SphereCollision>& sphere,
                             const DomeCollision& dome){
         SphereCollision minSphere(dome.minRadius, dome.position);
@@ -2050,7 +2105,183 @@ namespace myTools{
         return HitData();
     }
     HitData StaticCollision(const MoveCollData<CapsuleCollision>& capsule,
-                            const DomeCollision& dome);
+                            const DomeCollision& dome){
+        const Segment& segment = capsule.collision.s;
+        Vector3 capVel = CulcVel(capsule.phys);
+        SphereCollision minSphere(dome.minRadius, dome.position);
+        //外にいるときは内側の球を避ける
+        if(!CollisionReturnFlag(minSphere, segment.p + segment.v * 0.5f)){
+            return SupConvexStaticCollision(CastToConvex(capsule.collision), capVel, CastToConvex(minSphere));
+        }
+        
+        //中にいるときは両端の球が minRadius からはみ出さないようにする
+        //hitNormal は球の版と同じく中心から外へ向け, hitPos は minRadius の球面上
+        float innerRadius = dome.minRadius - capsule.collision.radius;
+        Vector3 ends[2] = {segment.p - dome.position, segment.GetEndPoint() - dome.position};
+        int farIndex = ends[0].LengthSq() > ends[1].LengthSq() ? 0 : 1;
+        float farDist = ends[farIndex].Length();
+        if(farDist > innerRadius){
+            HitData ret;
+            ret.hit = true;
+            ret.time = 0.0f;
+            ret.hitNormal = farDist > MT_EPSILON ? ends[farIndex] / farDist : Vector3(0.0f, 1.0f, 0.0f);
+            ret.length = farDist - innerRadius;
+            ret.hitPos = dome.position + ret.hitNormal * dome.minRadius;
+            return ret;
+        }
+        
+        //端ごとに |end + vel * t| = innerRadius となる時刻(外へ出る方)を求めて早い方
+        HitData ret;
+        float a = capVel.LengthSq();
+        if(a == 0.0f){
+            return ret;
+        }
+        for(int i = 0; i < 2; ++i){
+            float b = dot(ends[i], capVel);
+            float c = ends[i].LengthSq() - innerRadius * innerRadius;
+            float t = (-b + sqrtf(b * b - a * c)) / a;
+            if(0.0f <= t && t <= 1.0f && (!ret.hit || t < ret.time)){
+                Vector3 onHitPos = ends[i] + capVel * t;
+                ret.hit = true;
+                ret.time = t;
+                ret.hitNormal = Normalize(onHitPos);
+                ret.hitPos = dome.position + ret.hitNormal * dome.minRadius;
+            }
+        }
+        return ret;
+    }
+    
+    //箱の面の軸で当たり始める時刻を絞ってから GJK で求める.
+    //角や辺は丸い形状と軸では分けられないので, 軸で求めた時刻は本当に当たる時刻より前になる
+    HitData StaticCollision(const MoveCollData<SphereCollision>& sphere,
+                            const CubeCollision& cube){
+        Vector3 center = sphere.collision.position;
+        float radius = sphere.collision.radius;
+        //すでに衝突しているとき
+        Vector3 closest = SupClosestPointCube(cube, center);
+        Vector3 fromClosest = center - closest;
+        float distSq = fromClosest.LengthSq();
+        if(distSq <= radius * radius){
+            HitData ret;
+            ret.hit = true;
+            ret.time = 0.0f;
+            if(distSq > MT_EPSILON * MT_EPSILON){
+                float dist = sqrtf(distSq);
+                ret.hitNormal = fromClosest / dist;
+                ret.hitPos = closest;
+                ret.length = radius - dist;
+                return ret;
+            }
+            //中心が箱の中にあるときは一番近い面から出す
+            Vector3 toCenter = center - cube.position;
+            float minDepth = 0.0f;
+            for(int i = 0; i < 3; ++i){
+                float local = dot(toCenter, cube.direct[i]);
+                float depth = cube.scale[i] - fabsf(local);
+                if(i == 0 || depth < minDepth){
+                    minDepth = depth;
+                    ret.hitNormal = local < 0.0f ? -cube.direct[i] : cube.direct[i];
+                }
+            }
+            ret.hitPos = center + ret.hitNormal * minDepth;
+            ret.length = radius + minDepth;
+            return ret;
+        }
+        
+        Vector3 vel = CulcVel(sphere.phys);
+        Vector3 toSphere = center - cube.position;
+        float first = 0.0f;
+        float last = 1.0f;
+        for(int i = 0; i < 3; ++i){
+            if(!SupAxisOverlapTime(dot(toSphere, cube.direct[i]), dot(vel, cube.direct[i]),
+                                   cube.scale[i] + radius, first, last)){
+                return HitData();
+            }
+        }
+        return SupConvexStaticCollision(CastToConvex(sphere.collision), vel, CastToConvex(cube), first);
+    }
+    
+    HitData StaticCollision(const MoveCollData<CapsuleCollision>& capsule,
+                            const CubeCollision& cube){
+        Vector3 vel = CulcVel(capsule.phys);
+        Vector3 half = capsule.collision.s.v * 0.5f;
+        Vector3 toCenter = capsule.collision.s.p + half - cube.position;
+        float radius = capsule.collision.radius;
+        float first = 0.0f;
+        float last = 1.0f;
+        //箱の面の軸
+        for(int i = 0; i < 3; ++i){
+            const Vector3& axis = cube.direct[i];
+            if(!SupAxisOverlapTime(dot(toCenter, axis), dot(vel, axis),
+                                   cube.scale[i] + fabsf(dot(half, axis)) + radius, first, last)){
+                return HitData();
+            }
+        }
+        //線分 x 箱の面の軸(正規化しないので半径も軸の長さ倍)
+        for(int i = 0; i < 3; ++i){
+            Vector3 axis = cross(half, cube.direct[i]);
+            float axisLength = axis.Length();
+            if(axisLength < MT_EPSILON){
+                continue;
+            }
+            float cubeRadius = 0.0f;
+            for(int j = 0; j < 3; ++j){
+                cubeRadius += cube.scale[j] * fabsf(dot(cube.direct[j], axis));
+            }
+            if(!SupAxisOverlapTime(dot(toCenter, axis), dot(vel, axis),
+                                   cubeRadius + radius * axisLength, first, last)){
+                return HitData();
+            }
+        }
+        return SupConvexStaticCollision(CastToConvex(capsule.collision), vel, CastToConvex(cube), first);
+    }
+    
+    //cube の中で dir の向きに一番遠い面・辺・角の中心
+    Vector3 SupCubeFeatureCenter(const CubeCollision& cube, const Vector3& dir){
+        //これより dir と垂直に近い軸は面の広がる向きとみなす
+        const float flatDot = 1.0e-3f;
+        Vector3 ret = cube.position;
+        for(int i = 0; i < 3; ++i){
+            float d = dot(cube.direct[i], dir);
+            if(fabsf(d) > flatDot){
+                ret += cube.direct[i] * (d > 0.0f ? cube.scale[i] : -cube.scale[i]);
+            }
+        }
+        return ret;
+    }
+    
+    //cube2 が cube2Vel, 2つの相対的な移動が vel のとき
+    HitData SupCubeCubeCollision(const CubeCollision& cube1, const CubeCollision& cube2,
+                                 const Vector3& cube2Vel, const Vector3& vel){
+        HitData ret;
+        float t;
+        float depth;
+        Vector3 normal;
+        if(!SupCubeCubeSweep(cube1, cube2, vel, t, normal, depth)){
+            return ret;
+        }
+        ret.hit = true;
+        ret.time = t;
+        ret.length = depth;
+        ret.hitNormal = normal;
+        //当たった時の cube2 の, cube1 へ一番出ているところ
+        CubeCollision moved = cube2;
+        moved.position += cube2Vel * t;
+        ret.hitPos = SupCubeFeatureCenter(moved, -normal);
+        return ret;
+    }
+    
+    HitData StaticCollision(const MoveCollData<CubeCollision>& cube,
+                            const CubeCollision& staticCube){
+        Vector3 vel = CulcVel(cube.phys);
+        return SupCubeCubeCollision(staticCube, cube.collision, vel, vel);
+    }
+    
+    HitData MoveCollision(const MoveCollData<CubeCollision>& cube1,
+                          const MoveCollData<CubeCollision>& cube2){
+        Vector3 cube2Vel = CulcVel(cube2.phys);
+        return SupCubeCubeCollision(cube1.collision, cube2.collision, cube2Vel, cube2Vel - CulcVel(cube1.phys));
+    }
     
     void CulcDomeFix(float delta, MoveCollData<SphereCollision>& sphere,const DomeCollision& dome){
         HitData data = StaticCollision(sphere, dome);
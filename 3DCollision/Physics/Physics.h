@@ -12,6 +12,7 @@
 
 #include "Vector.h"
 #include "Collision.h"
+#include "BodyStore.h"
 #include <iostream>
 #include <math.h>
 
@@ -80,19 +81,21 @@ namespace myTools {
             return preVel;
         }
         
+        //修正量は重み付きの合計だけ持っておく(PreFixで使うのはそれだけ)
         void AddFix(const Vector3& posFix, const Vector3& velFix){
-            posSum += posFix.LengthSq();
-            posFixes.push_back(posFix);
+            float posLengthSq = posFix.LengthSq();
+            posSum += posLengthSq;
+            posFixSum += posFix * posLengthSq;
             velSum += velFix.LengthSq();
-            velFixes.push_back(velFix);
+            velFixSum += velFix;
         }
         
         void PreFix();
         void Fix();
         
         void ResetFix(){
-            posFixes.clear();
-            velFixes.clear();
+            posFixSum = Vector3();
+            velFixSum = Vector3();
 
             posSum = 0.0f;
             velSum = 0.0f;
@@ -103,6 +106,10 @@ namespace myTools {
         }
         
         Vector3 CulcRestrictPower(const Vector3& impulse);
+        
+        static float GetMaxVelocity(){
+            return maxVelocity;
+        }
     private:
         static float maxVelocity;
         
@@ -114,11 +121,11 @@ namespace myTools {
         Vector3 preVel;
         float mass = 1.0f;
         float massRate = 1.0f;
-        std::vector<Vector3> posFixes;
-        std::vector<Vector3> velFixes;
+        Vector3 posFixSum;
+        Vector3 velFixSum;
         
-        float posSum;
-        float velSum;
+        float posSum = 0.0f;
+        float velSum = 0.0f;
         
         std::vector<Vector3> restrictVectores;
     };
@@ -132,6 +139,15 @@ namespace myTools {
         Vector3 hitNormal;
     };
     
+    //CulcFix で1つのペアから出る修正量(AddFix に渡す分)
+    struct ContactFix{
+        bool hit = false;
+        Vector3 lhsPosFix;
+        Vector3 lhsVelFix;
+        Vector3 rhsPosFix;
+        Vector3 rhsVelFix;
+    };
+    
     template<typename Ty>
     struct MoveCollData{
         MoveCollData() = default;
@@ -139,10 +155,18 @@ namespace myTools {
         Ty collision;
         Physics phys;
         AABBCollision aabb;
+        //BodyStoreで管理している場合の本体
+        BodyHandle body;
     };
     
     Vector3 CulcVel(const Physics& phys);
     
+    //移動前と移動後を包むAABBをaabbに入れる(ブロードフェーズ用)
+    void CulcAABB(MoveCollData<SphereCollision>& sphere);
+    void CulcAABB(MoveCollData<CylinderCollision>& cylinder);
+    void CulcAABB(MoveCollData<CapsuleCollision>& capsule);
+    void CulcAABB(MoveCollData<CubeCollision>& cube);
+    
     //Sphere and Sphere HitTime
     HitData MoveCollision(const MoveCollData<SphereCollision>& sphere1,
                           const MoveCollData<SphereCollision>& sphere2);
@@ -173,6 +197,10 @@ namespace myTools {
     HitData MoveCollision(const MoveCollData<CapsuleCollision>& cap1,
                           const MoveCollData<CapsuleCollision>& cap2);
     
+    //Cube and Cube (SAT). hitNormal は cube1 から cube2 へ向く
+    HitData MoveCollision(const MoveCollData<CubeCollision>& cube1,
+                          const MoveCollData<CubeCollision>& cube2);
+    
     
     HitData StaticCollision(const MoveCollData<SphereCollision>& sphere,
                             const Point& point);
@@ -221,17 +249,33 @@ namespace myTools {
     
     HitData StaticCollision(const MoveCollData<SphereCollision>& sphere,
                             const SphereCollision& staticSphere);
-    HitData StaticCollision(const MoveCollData<CapsuleCollision>& capsule,
-                            const DomeCollision& staticSphere);
-    
     HitData StaticCollision(const MoveCollData<SphereCollision>& sphere,
                             const DomeCollision& dome);
     HitData StaticCollision(const MoveCollData<CapsuleCollision>& capsule,
                             const DomeCollision& dome);
     
+    HitData StaticCollision(const MoveCollData<SphereCollision>& sphere,
+                            const CubeCollision& cube);
+    HitData StaticCollision(const MoveCollData<CapsuleCollision>& capsule,
+                            const CubeCollision& cube);
+    HitData StaticCollision(const MoveCollData<CubeCollision>& cube,
+                            const CubeCollision& staticCube);
+    
+    template<typename Ty1, typename Ty2>
+    void CulcFix(float delta, Ty1& lhs, Ty2& rhs, const HitData& data);
+
     template<typename Ty1, typename Ty2>
     void CulcFix(float delta, Ty1& lhs, Ty2& rhs){
-        HitData data = MoveCollision(lhs, rhs);
+        CulcFix(delta, lhs, rhs, MoveCollision(lhs, rhs));
+    }
+
+    /**
+     *  @tips   Only computes the fix into fix and leaves lhs / rhs unchanged.
+     *          Can be called in parallel when each pair writes its own fix (see ContactFixBuffer)
+     */
+    template<typename Ty1, typename Ty2>
+    void CulcFix(float delta, Ty1& lhs, Ty2& rhs, const HitData& data, ContactFix& fix){
+        fix = ContactFix();
         if(!data.hit){
             return;
         }
@@ -329,8 +373,23 @@ namespace myTools {
         v1 += lhsImpulse * lhsMassRate;
         v2 += rhsImpulse * rhsMassRate;
         
-        lhs.phys.AddFix(v1 * (delta - hitTime) + lhsVel * hitTime + lhsPos - lhs.phys.GetPrePos() + lhsSpringFix, lhsImpulse * lhsMassRate + lhsSpringPower);
-        rhs.phys.AddFix(v2 * (delta - hitTime) + rhsVel * hitTime + rhsPos - rhs.phys.GetPrePos() + rhsSpringFix, rhsImpulse * rhsMassRate + rhsSpringPower);
+        fix.hit = true;
+        fix.lhsPosFix = v1 * (delta - hitTime) + lhsVel * hitTime + lhsPos - lhs.phys.GetPrePos() + lhsSpringFix;
+        fix.lhsVelFix = lhsImpulse * lhsMassRate + lhsSpringPower;
+        fix.rhsPosFix = v2 * (delta - hitTime) + rhsVel * hitTime + rhsPos - rhs.phys.GetPrePos() + rhsSpringFix;
+        fix.rhsVelFix = rhsImpulse * rhsMassRate + rhsSpringPower;
+    }
+
+    //判定結果が先に求めてある場合(SphereTOIBatch など)
+    template<typename Ty1, typename Ty2>
+    void CulcFix(float delta, Ty1& lhs, Ty2& rhs, const HitData& data){
+        ContactFix fix;
+        CulcFix(delta, lhs, rhs, data, fix);
+        if(!fix.hit){
+            return;
+        }
+        lhs.phys.AddFix(fix.lhsPosFix, fix.lhsVelFix);
+        rhs.phys.AddFix(fix.rhsPosFix, fix.rhsVelFix);
     }
     
     //衝突方向の速度は消す
@@ -0,0 +1,263 @@
+//
+//  SphereBatch.cpp
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/28.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#include "SphereBatch.h"
+#include "JobSystem.h"
+#include <math.h>
+
+namespace myTools {
+
+#if defined(MT_USE_AVX)
+    namespace {
+        struct Vector3x8 {
+            __m256 x;
+            __m256 y;
+            __m256 z;
+        };
+
+        inline Vector3x8 Load8(const std::vector<float>* fields, int x, int first){
+            return {
+                _mm256_loadu_ps(fields[x].data() + first),
+                _mm256_loadu_ps(fields[x + 1].data() + first),
+                _mm256_loadu_ps(fields[x + 2].data() + first)
+            };
+        }
+        inline Vector3x8 Add8(const Vector3x8& a, const Vector3x8& b){
+            return { _mm256_add_ps(a.x, b.x), _mm256_add_ps(a.y, b.y), _mm256_add_ps(a.z, b.z) };
+        }
+        inline Vector3x8 Sub8(const Vector3x8& a, const Vector3x8& b){
+            return { _mm256_sub_ps(a.x, b.x), _mm256_sub_ps(a.y, b.y), _mm256_sub_ps(a.z, b.z) };
+        }
+        inline Vector3x8 Mul8(const Vector3x8& a, __m256 s){
+            return { _mm256_mul_ps(a.x, s), _mm256_mul_ps(a.y, s), _mm256_mul_ps(a.z, s) };
+        }
+        inline Vector3x8 Div8(const Vector3x8& a, __m256 s){
+            return { _mm256_div_ps(a.x, s), _mm256_div_ps(a.y, s), _mm256_div_ps(a.z, s) };
+        }
+        inline __m256 Dot8(const Vector3x8& a, const Vector3x8& b){
+            return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a.x, b.x), _mm256_mul_ps(a.y, b.y)), _mm256_mul_ps(a.z, b.z));
+        }
+        //Normalize と同じく長さ 0 なら 0 を返す
+        inline Vector3x8 Normalize8(const Vector3x8& v){
+            __m256 zero = _mm256_setzero_ps();
+            __m256 sq = _mm256_sqrt_ps(Dot8(v, v));
+            __m256 normalize = _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(1.0f), sq), _mm256_cmp_ps(sq, zero, _CMP_NEQ_UQ));
+            return Mul8(v, normalize);
+        }
+        //mask が立っているレーンは a, それ以外は b
+        inline Vector3x8 Select8(__m256 mask, const Vector3x8& a, const Vector3x8& b){
+            return { _mm256_blendv_ps(b.x, a.x, mask), _mm256_blendv_ps(b.y, a.y, mask), _mm256_blendv_ps(b.z, a.z, mask) };
+        }
+        inline void Store8(const Vector3x8& v, float* x, float* y, float* z){
+            _mm256_storeu_ps(x, v.x);
+            _mm256_storeu_ps(y, v.y);
+            _mm256_storeu_ps(z, v.z);
+        }
+    }
+#endif
+
+    void SphereTOIBatch::Clear(){
+        for(auto& field : fields){
+            field.clear();
+        }
+        count = 0;
+    }
+
+    void SphereTOIBatch::Reserve(int count){
+        int padded = (count + laneCount - 1) / laneCount * laneCount;
+        for(auto& field : fields){
+            field.reserve(padded);
+        }
+    }
+
+    void SphereTOIBatch::Add(const MoveCollData<SphereCollision>& lhs, const MoveCollData<SphereCollision>& rhs){
+        if(count % laneCount == 0){
+            for(auto& field : fields){
+                field.resize(count + laneCount, 0.0f);
+            }
+        }
+        const Vector3 values[] = {
+            lhs.collision.position, rhs.collision.position,
+            lhs.phys.GetPosition(), lhs.phys.GetPrePos(),
+            rhs.phys.GetPosition(), rhs.phys.GetPrePos()
+        };
+        for(int i = 0; i < 6; ++i){
+            fields[LhsCollX + i * 3][count] = values[i].x;
+            fields[LhsCollX + i * 3 + 1][count] = values[i].y;
+            fields[LhsCollX + i * 3 + 2][count] = values[i].z;
+        }
+        fields[LhsRadius][count] = lhs.collision.radius;
+        fields[RhsRadius][count] = rhs.collision.radius;
+        ++count;
+    }
+
+    void SphereTOIBatch::Culc(std::vector<HitData>& results) const {
+        results.resize(count);
+#if defined(MT_USE_AVX)
+        for(int first = 0; first < count; first += laneCount){
+            CulcLanes(first, results.data() + first);
+        }
+#else
+        for(int i = 0; i < count; ++i){
+            CulcScalar(i, results[i]);
+        }
+#endif
+    }
+
+    void SphereTOIBatch::Culc(std::vector<HitData>& results, JobSystem& jobs) const {
+        results.resize(count);
+        int groupCount = (count + laneCount - 1) / laneCount;
+        jobs.ParallelFor(0, groupCount, 64, [&](int first, int last){
+            for(int group = first; group < last; ++group){
+                CulcLanes(group * laneCount, results.data() + group * laneCount);
+            }
+        });
+    }
+
+    //MoveCollision(Sphere, Sphere) と同じ式
+    void SphereTOIBatch::CulcScalar(int index, HitData& result) const {
+        auto get = [&](int field){
+            return Vector3(fields[field][index], fields[field + 1][index], fields[field + 2][index]);
+        };
+        Vector3 lhsColl = get(LhsCollX);
+        Vector3 rhsColl = get(RhsCollX);
+        float lhsRadius = fields[LhsRadius][index];
+        float rhsRadius = fields[RhsRadius][index];
+
+        result = HitData();
+        //移動前に当たってるかチェック
+        if((lhsColl - rhsColl).LengthSq() <= (lhsRadius + rhsRadius) * (lhsRadius + rhsRadius)){
+            result.hit = true;
+            result.time = 0.0f;
+            Vector3 from1To2 = rhsColl - lhsColl;
+            result.hitPos = from1To2 * lhsRadius / (lhsRadius + rhsRadius) + lhsColl;
+            result.length = (lhsRadius + rhsRadius) - from1To2.Length();
+            result.hitNormal = Normalize(from1To2);
+            return;
+        }
+
+        Vector3 rhsPos = get(RhsPosX);
+        Vector3 start = get(LhsPosX) - rhsPos;
+        Vector3 vel = (get(LhsPreX) - get(RhsPreX)) - start;
+        Vector3 rhsVel = get(RhsPreX) - rhsPos;
+
+        float a = vel.LengthSq();
+        float b = dot(start, vel);
+        float c = start.LengthSq() - (lhsRadius + rhsRadius) * (lhsRadius + rhsRadius);
+        float ans = b * b - a * c;
+        if(ans < 0 || a == 0){
+            return;
+        }
+
+        auto setHit = [&](float t){
+            result.hit = true;
+            result.time = t;
+            Vector3 pos = rhsPos + rhsVel * t;
+            result.hitPos = pos + (start + vel * t) * rhsRadius / (rhsRadius + lhsRadius);
+            result.hitNormal = Normalize(result.hitPos - pos);
+        };
+        if(ans < MT_EPSILON){
+            float t = -b / a;
+            if(t < 0.0f || 1.0f < t){
+                return;
+            }
+            setHit(t);
+        }
+        float t0 = (-b - sqrtf(ans)) / a;
+        if(0.0f <= t0 && t0 <= 1.0f){
+            setHit(t0);
+        }
+    }
+
+#if defined(MT_USE_AVX)
+    void SphereTOIBatch::CulcLanes(int first, HitData* results) const {
+        __m256 zero = _mm256_setzero_ps();
+        __m256 one = _mm256_set1_ps(1.0f);
+        __m256 signMask = _mm256_set1_ps(-0.0f);
+
+        Vector3x8 lhsColl = Load8(fields, LhsCollX, first);
+        Vector3x8 rhsColl = Load8(fields, RhsCollX, first);
+        __m256 lhsRadius = _mm256_loadu_ps(fields[LhsRadius].data() + first);
+        __m256 rhsRadius = _mm256_loadu_ps(fields[RhsRadius].data() + first);
+        __m256 radius = _mm256_add_ps(lhsRadius, rhsRadius);
+        __m256 radiusSq = _mm256_mul_ps(radius, radius);
+
+        //移動前に当たっているレーン
+        Vector3x8 from1To2 = Sub8(rhsColl, lhsColl);
+        __m256 distSq = Dot8(from1To2, from1To2);
+        __m256 overlap = _mm256_cmp_ps(distSq, radiusSq, _CMP_LE_OQ);
+        Vector3x8 overlapPos = Add8(Div8(Mul8(from1To2, lhsRadius), radius), lhsColl);
+        __m256 overlapLength = _mm256_sub_ps(radius, _mm256_sqrt_ps(distSq));
+        Vector3x8 overlapNormal = Normalize8(from1To2);
+
+        //移動中に当たるレーン
+        Vector3x8 rhsPos = Load8(fields, RhsPosX, first);
+        Vector3x8 rhsPre = Load8(fields, RhsPreX, first);
+        Vector3x8 start = Sub8(Load8(fields, LhsPosX, first), rhsPos);
+        Vector3x8 vel = Sub8(Sub8(Load8(fields, LhsPreX, first), rhsPre), start);
+        Vector3x8 rhsVel = Sub8(rhsPre, rhsPos);
+
+        __m256 a = Dot8(vel, vel);
+        __m256 b = Dot8(start, vel);
+        __m256 c = _mm256_sub_ps(Dot8(start, start), radiusSq);
+        __m256 ans = _mm256_sub_ps(_mm256_mul_ps(b, b), _mm256_mul_ps(a, c));
+        __m256 negB = _mm256_xor_ps(b, signMask);
+
+        __m256 invalid = _mm256_or_ps(_mm256_cmp_ps(ans, zero, _CMP_LT_OQ), _mm256_cmp_ps(a, zero, _CMP_EQ_OQ));
+        __m256 move = _mm256_andnot_ps(_mm256_or_ps(overlap, invalid), _mm256_castsi256_ps(_mm256_set1_epi32(-1)));
+
+        //判別式がほぼ 0 (接する)場合
+        __m256 tangent = _mm256_and_ps(move, _mm256_cmp_ps(ans, _mm256_set1_ps(MT_EPSILON), _CMP_LT_OQ));
+        __m256 tangentTime = _mm256_div_ps(negB, a);
+        __m256 tangentOut = _mm256_or_ps(_mm256_cmp_ps(tangentTime, zero, _CMP_LT_OQ), _mm256_cmp_ps(one, tangentTime, _CMP_LT_OQ));
+        __m256 tangentHit = _mm256_andnot_ps(tangentOut, tangent);
+        //接して範囲外ならそこで打ち切り
+        __m256 proceed = _mm256_andnot_ps(_mm256_and_ps(tangent, tangentOut), move);
+
+        __m256 t0 = _mm256_div_ps(_mm256_sub_ps(negB, _mm256_sqrt_ps(_mm256_max_ps(ans, zero))), a);
+        __m256 t0Hit = _mm256_and_ps(proceed, _mm256_and_ps(_mm256_cmp_ps(zero, t0, _CMP_LE_OQ), _mm256_cmp_ps(t0, one, _CMP_LE_OQ)));
+        __m256 moveHit = _mm256_or_ps(t0Hit, tangentHit);
+        __m256 t = _mm256_blendv_ps(tangentTime, t0, t0Hit);
+
+        Vector3x8 pos = Add8(rhsPos, Mul8(rhsVel, t));
+        Vector3x8 movePos = Add8(pos, Div8(Mul8(Add8(start, Mul8(vel, t)), rhsRadius), _mm256_add_ps(rhsRadius, lhsRadius)));
+        Vector3x8 moveNormal = Normalize8(Sub8(movePos, pos));
+
+        //当たらないレーンは HitData() と同じく 0
+        Vector3x8 none = { zero, zero, zero };
+        Vector3x8 hitPos = Select8(overlap, overlapPos, Select8(moveHit, movePos, none));
+        Vector3x8 hitNormal = Select8(overlap, overlapNormal, Select8(moveHit, moveNormal, none));
+        __m256 time = _mm256_and_ps(moveHit, t);
+        __m256 length = _mm256_and_ps(overlap, overlapLength);
+        int hitMask = _mm256_movemask_ps(_mm256_or_ps(overlap, moveHit));
+
+        alignas(32) float out[8][laneCount];
+        _mm256_store_ps(out[0], time);
+        _mm256_store_ps(out[1], length);
+        Store8(hitPos, out[2], out[3], out[4]);
+        Store8(hitNormal, out[5], out[6], out[7]);
+
+        int lanes = count - first < laneCount ? count - first : laneCount;
+        for(int i = 0; i < lanes; ++i){
+            HitData& result = results[i];
+            result.hit = (hitMask >> i) & 1;
+            result.time = out[0][i];
+            result.length = out[1][i];
+            result.hitPos = Vector3(out[2][i], out[3][i], out[4][i]);
+            result.hitNormal = Vector3(out[5][i], out[6][i], out[7][i]);
+        }
+    }
+#else
+    void SphereTOIBatch::CulcLanes(int first, HitData* results) const {
+        int lanes = count - first < laneCount ? count - first : laneCount;
+        for(int i = 0; i < lanes; ++i){
+            CulcScalar(first + i, results[i]);
+        }
+    }
+#endif
+}// namespace myTools
@@ -0,0 +1,71 @@
+//
+//  SphereBatch.h
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/28.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#ifndef SphereBatch_h
+#define SphereBatch_h
+
+#include "Physics.h"
+#include <vector>
+
+namespace myTools {
+
+    class JobSystem;
+
+    /**
+     *  @tips   Batched sphere / sphere MoveCollision.
+     *          Add packs candidate pairs into per-field arrays (SoA) and Culc computes the HitData of every pair.
+     *          With AVX, 8 pairs are computed at once (MT_USE_AVX, see Simd.h)
+     *
+     *          Difference from the scalar MoveCollision:
+     *          Without AVX the same expressions run in the same order, so the results are bit-identical.
+     *          The AVX version keeps the order too, but if the compiler fuses multiply and add into FMA,
+     *          time / hitPos / hitNormal / length may differ by about 1e-5 relative.
+     *          hit can only differ when the overlap test, discriminant or time is within a few ulp of the boundary
+     */
+    class SphereTOIBatch {
+    public:
+        static const int laneCount = 8;
+
+        void Clear();
+        void Reserve(int count);
+        void Add(const MoveCollData<SphereCollision>& lhs, const MoveCollData<SphereCollision>& rhs);
+        int GetCount() const {
+            return count;
+        }
+
+        /**
+         *  @tips   results[i] gets the same result as MoveCollision(lhs, rhs) for the i-th Add
+         */
+        void Culc(std::vector<HitData>& results) const;
+        //8 ペアの組ごとにジョブに分けて計算する(結果は上と同じ)
+        void Culc(std::vector<HitData>& results, JobSystem& jobs) const;
+
+    private:
+        enum Field {
+            //移動前の当たり判定の位置
+            LhsCollX, LhsCollY, LhsCollZ,
+            RhsCollX, RhsCollY, RhsCollZ,
+            //移動前と移動後の位置
+            LhsPosX, LhsPosY, LhsPosZ,
+            LhsPreX, LhsPreY, LhsPreZ,
+            RhsPosX, RhsPosY, RhsPosZ,
+            RhsPreX, RhsPreY, RhsPreZ,
+            LhsRadius, RhsRadius,
+            FieldCount
+        };
+
+        void CulcScalar(int index, HitData& result) const;
+        void CulcLanes(int first, HitData* results) const;
+
+        //laneCount の倍数に切り上げた長さで持つ(余りは 0 埋め)
+        std::vector<float> fields[FieldCount];
+        int count = 0;
+    };
+}// namespace myTools
+
+#endif /* SphereBatch_h */
@@ -10,6 +10,8 @@
 #include "Quaternion.h"
 #include "Transform.h"
 #include <math.h>
+#include <string.h>
+#include <algorithm>
 namespace myTools {
     
     std::vector<Vertex> PrimitiveMesh::Update(){
@@ -21,6 +23,26 @@ namespace myTools {
         return vertex;
     }
     
+    void PrimitiveMesh::GetBoundingSphere(Vector3& center, float& radius){
+        center = Vector3();
+        radius = 0.0f;
+        if(vert.empty()){
+            return;
+        }
+        Vector3 min = vert[0];
+        Vector3 max = vert[0];
+        for(auto& v : vert){
+            for(int i = 0; i < 3; ++i){
+                min[i] = fminf(min[i], v[i]);
+                max[i] = fmaxf(max[i], v[i]);
+            }
+        }
+        center = (min + max) * 0.5f;
+        for(auto& v : vert){
+            radius = fmaxf(radius, (v - center).Length());
+        }
+    }
+    
     //Line
     std::vector<GLuint> LineMesh::index;
     unsigned int LineMesh::vertexNum;
@@ -40,10 +62,12 @@ namespace myTools {
     void LineMesh::SetPoint(const Vector3& p1, const Vector3& p2){
         vert[0] = p1;
         vert[1] = p2;
+        SetDirty(DirtyTransform);
     }
     void LineMesh::SetPoint(unsigned int index, const Vector3& p){
         if(index < vertexNum){
             vert[index] = p;
+            SetDirty(DirtyTransform);
         }
     }
     
@@ -87,10 +111,12 @@ namespace myTools {
         vert[0] = p1;
         vert[1] = p2;
         vert[2] = p3;
+        SetDirty(DirtyTransform);
     }
     void Triangle::SetPoint(unsigned int index, const Vector3& p){
         if(index < vertexNum){
             vert[index] = p;
+            SetDirty(DirtyTransform);
         }
     }
     
@@ -140,10 +166,12 @@ namespace myTools {
         vert[1] = p2;
         vert[2] = p3;
         vert[3] = p4;
+        SetDirty(DirtyTransform);
     }
     void Square::SetPoint(unsigned int index, const Vector3& p){
         if(index < vertexNum){
             vert[index] = p;
+            SetDirty(DirtyTransform);
         }
     }
     
@@ -184,8 +212,12 @@ namespace myTools {
     void Sphere::SetRadius(float radius){
         this->radius = radius;
         SetDivideNum(divideNum);
+        SetDirty(DirtyTransform);
     }
     void Sphere::SetDivideNum(int num){
+        if((unsigned int)num != divideNum){
+            SetDirty(DirtyTopology);
+        }
         divideNum = num;
         int vertNum = (divideNum * 4) * (divideNum * 2 - 1) + 2 ;
         vert.resize(vertNum);
@@ -225,6 +257,41 @@ namespace myTools {
         return vertex;
     }
     
+    std::vector<Vector4> Sphere::InstanceTemplate(){
+        //半径 1 で作り直してから戻す
+        float currentRadius = radius;
+        radius = 1.0f;
+        SetDivideNum(divideNum);
+        std::vector<Vector4> vertex(vert.size());
+        for(int i = 0; i < vert.size(); ++i){
+            vertex[i] = Vector4(vert[i].x, vert[i].y, vert[i].z, 0.0f);
+        }
+        radius = currentRadius;
+        SetDivideNum(divideNum);
+        return vertex;
+    }
+    
+    MeshInstance Sphere::GetInstance(){
+        MeshInstance instance;
+        instance.position = position;
+        instance.radius = radius;
+        instance.color = color;
+        return instance;
+    }
+    
+    void Sphere::GetBoundingSphere(Vector3& center, float& radius){
+        center = position;
+        radius = this->radius;
+    }
+    
+    PrimitiveMesh* Sphere::CreateLOD(int level, unsigned int& divideNum){
+        divideNum = this->divideNum >> level;
+        if(divideNum == 0){
+            return nullptr;
+        }
+        return new Sphere(divideNum);
+    }
+    
     std::vector<GLuint>& Sphere::LineDrawMode() {
         int squareNum = (divideNum * (divideNum - 1) * 4 * 2);
         int triangleNum = (divideNum * 4 * 2);
@@ -335,15 +402,21 @@ namespace myTools {
     }
     void CapsuleMesh::SetPosition(const Vector3& pos){
         segment.p = pos;
+        SetDirty(DirtyTransform);
     }
     void CapsuleMesh::SetLength(const Vector3& length){
         segment.v = length;
+        SetDirty(DirtyTransform);
     }
     void CapsuleMesh::SetRadius(const float &radius){
         this->radius = radius;
         SetDivideNum(divideNum);
+        SetDirty(DirtyTransform);
     }
     void CapsuleMesh::SetDivideNum(unsigned int num){
+        if(num != divideNum){
+            SetDirty(DirtyTopology);
+        }
         divideNum = num;
         int vertNum = divideNum * divideNum * 4 * 2 + 2;
         int vInCyrcle = divideNum * 4;
@@ -405,6 +478,42 @@ namespace myTools {
         }
         return vertex;
     }
+    std::vector<Vector4> CapsuleMesh::InstanceTemplate(){
+        float currentRadius = radius;
+        radius = 1.0f;
+        SetDivideNum(divideNum);
+        std::vector<Vector4> vertex(vert.size());
+        for(int i = 0; i < vert.size(); ++i){
+            //上半分の球は Update と同じく長さの分だけ上にずらす
+            float top = (i < sphereHalfIndex || i == topIndex) ? 1.0f : 0.0f;
+            vertex[i] = Vector4(vert[i].x, vert[i].y, vert[i].z, top);
+        }
+        radius = currentRadius;
+        SetDivideNum(divideNum);
+        return vertex;
+    }
+    MeshInstance CapsuleMesh::GetInstance(){
+        MeshInstance instance;
+        instance.length = segment.v.Length();
+        if(instance.length > 0.0f){
+            instance.rotation = MakeQuatVectorToVector(Vector3(0.0f,1.0f,0.0f), segment.v / instance.length);
+        }
+        instance.position = segment.p;
+        instance.radius = radius;
+        instance.color = color;
+        return instance;
+    }
+    void CapsuleMesh::GetBoundingSphere(Vector3& center, float& radius){
+        center = segment.p + segment.v * 0.5f;
+        radius = this->radius + segment.v.Length() * 0.5f;
+    }
+    PrimitiveMesh* CapsuleMesh::CreateLOD(int level, unsigned int& divideNum){
+        divideNum = this->divideNum >> level;
+        if(divideNum == 0){
+            return nullptr;
+        }
+        return new CapsuleMesh(divideNum);
+    }
     unsigned int CapsuleMesh::VertexNum() {
         //TODO: 後で直す
         return divideNum * divideNum * 4 * 2 + 2;
@@ -536,6 +645,11 @@ namespace myTools {
         return vertex;
     }
     
+    void Cube::GetBoundingSphere(Vector3& center, float& radius){
+        center = position;
+        radius = scale.Length();
+    }
+    
     std::vector<GLuint>& Cube::LineDrawMode(){
         if(index.size() != 24){
             index.resize(24);
@@ -591,6 +705,22 @@ namespace myTools {
         return vbo;
     }
     
+    //書き込み用に永続マップしたバッファ. 作れなければ 0
+    GLuint CreatePersistentBuffer(GLenum type, GLsizeiptr size, void*& mapped){
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        GLuint buffer;
+        glGenBuffers(1,&buffer);
+        glBindBuffer(type, buffer);
+        glBufferStorage(type, size, nullptr, flags);
+        mapped = glMapBufferRange(type, 0, size, flags);
+        glBindBuffer(type, 0);
+        if(!mapped){
+            glDeleteBuffers(1,&buffer);
+            return 0;
+        }
+        return buffer;
+    }
+    
     GLuint CreateVAO(GLuint vbo, GLuint ibo){
         GLuint vao = 0;
         glGenVertexArrays(1,&vao);
@@ -609,6 +739,33 @@ namespace myTools {
         return vao;
     }
     
+    void SetInstanceAttrib(GLuint location, GLint size, size_t offset){
+        glEnableVertexAttribArray(location);
+        glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, sizeof(MeshInstance), reinterpret_cast<GLvoid*>(offset));
+        glVertexAttribDivisor(location, 1);
+    }
+    
+    GLuint CreateInstanceVAO(GLuint templateVbo, GLuint instanceVbo, GLuint ibo){
+        GLuint vao = 0;
+        glGenVertexArrays(1,&vao);
+        glBindVertexArray(vao);
+        glBindBuffer(GL_ARRAY_BUFFER, templateVbo);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Vector4), 0);
+        
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVbo);
+        SetInstanceAttrib(1, 4, offsetof(MeshInstance, rotation));
+        SetInstanceAttrib(2, 3, offsetof(MeshInstance, position));
+        SetInstanceAttrib(3, 1, offsetof(MeshInstance, radius));
+        SetInstanceAttrib(4, 1, offsetof(MeshInstance, length));
+        SetInstanceAttrib(5, 4, offsetof(MeshInstance, color));
+        
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return vao;
+    }
+    
     GLuint CompileShader(GLenum type, const GLchar* string){
         GLuint shader = glCreateShader(type);
         glShaderSource(shader, 1, &string, nullptr);
@@ -674,6 +831,25 @@ namespace myTools {
     "   gl_Position = matMVP * vec4(vPosition, 1.0);"
     "}";
     
+    //rotation は (x, y, z, w) のクォータニオン
+    const char* instanceVsCode =
+    "#version 410\n"
+    "layout(location=0) in vec4 vTemplate;"
+    "layout(location=1) in vec4 iRotation;"
+    "layout(location=2) in vec3 iPosition;"
+    "layout(location=3) in float iRadius;"
+    "layout(location=4) in float iLength;"
+    "layout(location=5) in vec4 iColor;"
+    "layout(location=0) out vec4 outColor;"
+    "uniform mat4x4 matMVP;"
+    "void main() {"
+    "   vec3 v = vTemplate.xyz * iRadius;"
+    "   v.y += vTemplate.w * iLength;"
+    "   v += 2.0 * cross(iRotation.xyz, cross(iRotation.xyz, v) + iRotation.w * v);"
+    "   outColor = iColor;"
+    "   gl_Position = matMVP * vec4(v + iPosition, 1.0);"
+    "}";
+    
     const char* fsCode =
     "#version 410\n"
     "layout(location=0) in vec4 outColor;"
@@ -687,6 +863,26 @@ namespace myTools {
         for(auto itr = meshes.begin(); itr != meshes.end(); ++itr){
             delete (*itr);
         }
+        for(auto& batch : instanceBatches){
+            for(auto mesh : batch.meshes){
+                delete mesh;
+            }
+            for(auto& level : batch.levels){
+                delete level.prototype;
+                glDeleteVertexArrays(1,&level.vao);
+                glDeleteBuffers(1,&level.ibo);
+                glDeleteBuffers(1,&level.instanceVbo);
+                glDeleteBuffers(1,&level.templateVbo);
+            }
+        }
+        if(instanceShader){
+            glDeleteProgram(instanceShader);
+        }
+        for(auto& fence : streamFences){
+            if(fence){
+                glDeleteSync(fence);
+            }
+        }
         if(shader){
             glDeleteShader(shader);
         }
@@ -705,7 +901,18 @@ namespace myTools {
         return instance;
     }
     bool PrimitiveDrawer::Init(){
-        vbo = CreateBuffer(GL_ARRAY_BUFFER, 1024 * 240000, nullptr);
+        const GLsizeiptr vboSize = 1024 * 240000;
+        if(GLEW_ARB_buffer_storage){
+            void* mapped = nullptr;
+            vbo = CreatePersistentBuffer(GL_ARRAY_BUFFER, vboSize, mapped);
+            streamMapped = static_cast<Vertex*>(mapped);
+            streamRegionSize = vboSize / streamRegionNum / sizeof(Vertex) * sizeof(Vertex);
+            isStreaming = vbo != 0;
+        }
+        //GL 4.1 (macOS など)
+        if(!isStreaming){
+            vbo = CreateBuffer(GL_ARRAY_BUFFER, vboSize, nullptr);
+        }
         ibo = CreateBuffer(GL_ELEMENT_ARRAY_BUFFER, 1024 * 720000, nullptr);
         vao = CreateVAO(vbo, ibo);
         shader = CreateShaderProgram(vsCode, fsCode);
@@ -718,6 +925,15 @@ namespace myTools {
         if(matMVPLoc < 0){
             return false;
         }
+        
+        instanceShader = CreateShaderProgram(instanceVsCode, fsCode);
+        if(!instanceShader){
+            return false;
+        }
+        instanceMatMVPLoc = glGetUniformLocation(instanceShader,"matMVP");
+        if(instanceMatMVPLoc < 0){
+            return false;
+        }
         return true;
     }
     void PrimitiveDrawer::AddMesh(PrimitiveMesh* mesh){
@@ -727,6 +943,9 @@ namespace myTools {
         glGetBufferParameteri64v(GL_ARRAY_BUFFER, GL_BUFFER_SIZE, &vboSize);
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
         glGetBufferParameteri64v(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &iboSize);
+        if(isStreaming){
+            vboSize = streamRegionSize;
+        }
         std::vector<Vertex> verteces = mesh->Update();
         std::vector<GLuint> indices;
         if(mode == Mode::LineMode){
@@ -752,83 +971,377 @@ namespace myTools {
             std::cerr << "WARNING : ibo size is not enough" << std::endl;
             return;
         }
-        glBufferSubData(GL_ARRAY_BUFFER, vboEnd, verticesBytes, verteces.data());
         glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, iboEnd, indicesBytes, indices.data());
         
         mesh->vboOffset = vboEnd;
         mesh->iboOffset = iboEnd;
+        mesh->iboCount = (GLsizei)indices.size();
         vboEnd += verticesBytes;
         iboEnd += indicesBytes;
         
+        GLuint first = mesh->vboOffset / sizeof(Vertex);
+        vertexShadow.resize(vboEnd / sizeof(Vertex));
+        std::copy(verteces.begin(), verteces.end(), vertexShadow.begin() + first);
+        dirtyRanges.push_back({first, mesh->VertexNum()});
+        mesh->vboVertexNum = mesh->VertexNum();
+        mesh->dirty = PrimitiveMesh::DirtyNone;
+        
         meshes.push_back(mesh);
     }
     
+    void PrimitiveDrawer::AddInstance(PrimitiveMesh* mesh){
+        PrimitiveMesh::InstanceShape shape = mesh->GetInstanceShape();
+        if(shape == PrimitiveMesh::InstanceShape::None){
+            AddMesh(mesh);
+            return;
+        }
+        unsigned int vertexNum = mesh->VertexNum();
+        for(auto& batch : instanceBatches){
+            if(batch.shape == shape && batch.vertexNum == vertexNum){
+                mesh->isInstanced = true;
+                batch.meshes.push_back(mesh);
+                return;
+            }
+        }
+        
+        InstanceBatch batch;
+        batch.shape = shape;
+        batch.vertexNum = vertexNum;
+        for(int i = 0; i < maxLODLevelNum; ++i){
+            InstanceLevel level;
+            level.prototype = mesh->CreateLOD(i, level.divideNum);
+            if(!level.prototype){
+                break;
+            }
+            //これ以上粗くならない
+            if(i > 0 && level.divideNum == batch.levels.back().divideNum){
+                delete level.prototype;
+                break;
+            }
+            if(!CreateInstanceLevel(level)){
+                delete level.prototype;
+                break;
+            }
+            batch.levels.push_back(level);
+        }
+        if(batch.levels.empty()){
+            delete mesh;
+            std::cerr << "WARNING : instance buffer is not created" << std::endl;
+            return;
+        }
+        mesh->isInstanced = true;
+        batch.meshes.push_back(mesh);
+        instanceBatches.push_back(batch);
+    }
+    
+    bool PrimitiveDrawer::CreateInstanceLevel(InstanceLevel& level){
+        std::vector<Vector4> templateVertex = level.prototype->InstanceTemplate();
+        level.templateVbo = CreateBuffer(GL_ARRAY_BUFFER, templateVertex.size() * sizeof(Vector4), templateVertex.data());
+        level.instanceVbo = CreateBuffer(GL_ARRAY_BUFFER, 0, nullptr);
+        level.ibo = CreateBuffer(GL_ELEMENT_ARRAY_BUFFER, 0, nullptr);
+        level.vao = CreateInstanceVAO(level.templateVbo, level.instanceVbo, level.ibo);
+        if(!level.templateVbo || !level.instanceVbo || !level.ibo || !level.vao){
+            glDeleteVertexArrays(1,&level.vao);
+            glDeleteBuffers(1,&level.ibo);
+            glDeleteBuffers(1,&level.instanceVbo);
+            glDeleteBuffers(1,&level.templateVbo);
+            return false;
+        }
+        SetInstanceIndex(level);
+        return true;
+    }
+    
+    void PrimitiveDrawer::SetInstanceIndex(InstanceLevel& level){
+        std::vector<GLuint> indices;
+        if(mode == Mode::LineMode){
+            indices = level.prototype->LineDrawMode();
+        }
+        else if(mode == Mode::PolygonMode){
+            indices = level.prototype->SurfaceDrawMode();
+        }
+        level.indexNum = (GLsizei)indices.size();
+        //VAO に ibo を結びつけたまま書き換える
+        glBindVertexArray(level.vao);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), indices.data(), GL_STATIC_DRAW);
+        glBindVertexArray(0);
+    }
+    
     void PrimitiveDrawer::Update(PrimitiveMesh* mesh){
-        std::vector<Vertex> verteces = mesh->Update();
-        glBindBuffer(GL_ARRAY_BUFFER, vbo);
-        glBufferSubData(GL_ARRAY_BUFFER, mesh->vboOffset, mesh->VertexNum() * sizeof(Vertex), verteces.data());
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        //インスタンス描画のメッシュは Draw でまとめて送る
+        if(mesh->isInstanced || mesh->dirty == PrimitiveMesh::DirtyNone){
+            return;
+        }
+        if(mesh->VertexNum() != mesh->vboVertexNum){
+            mesh->dirty = PrimitiveMesh::DirtyNone;
+            std::cerr << "WARNING : vertex num is changed" << std::endl;
+            return;
+        }
+        if(!IsVisible(mesh)){
+            if(!mesh->isCullDeferred){
+                mesh->isCullDeferred = true;
+                culledMeshes.push_back(mesh);
+            }
+            return;
+        }
+        GLuint first = mesh->vboOffset / sizeof(Vertex);
+        if(mesh->dirty & (PrimitiveMesh::DirtyTransform | PrimitiveMesh::DirtyTopology)){
+            std::vector<Vertex> verteces = mesh->Update();
+            std::copy(verteces.begin(), verteces.end(), vertexShadow.begin() + first);
+        }
+        else {
+            //色だけなら頂点は作り直さない
+            for(GLuint i = 0; i < mesh->vboVertexNum; ++i){
+                vertexShadow[first + i].color = mesh->color;
+            }
+        }
+        if(mesh->dirty & PrimitiveMesh::DirtyTopology){
+            isIndexDirty = true;
+        }
+        dirtyRanges.push_back({first, mesh->vboVertexNum});
+        mesh->dirty = PrimitiveMesh::DirtyNone;
+    }
+    
+    bool PrimitiveDrawer::IsVisible(PrimitiveMesh* mesh) const {
+        if(!hasFrustum){
+            return true;
+        }
+        Vector3 center;
+        float radius;
+        mesh->GetBoundingSphere(center, radius);
+        return frustum.IsVisible(center, radius);
+    }
+    
+    void PrimitiveDrawer::UpdateCulledMeshes(){
+        int count = 0;
+        for(int i = 0; i < culledMeshes.size(); ++i){
+            PrimitiveMesh* mesh = culledMeshes[i];
+            if(IsVisible(mesh)){
+                mesh->isCullDeferred = false;
+                Update(mesh);
+            }
+            else {
+                culledMeshes[count++] = mesh;
+            }
+        }
+        culledMeshes.resize(count);
+    }
+    
+    void PrimitiveDrawer::CoalesceRanges(std::vector<VertexRange>& ranges){
+        if(ranges.size() < 2){
+            return;
+        }
+        std::sort(ranges.begin(), ranges.end(), [](const VertexRange& lhs, const VertexRange& rhs){
+            return lhs.first < rhs.first;
+        });
+        int last = 0;
+        for(int i = 1; i < ranges.size(); ++i){
+            GLuint lastEnd = ranges[last].first + ranges[last].count;
+            if(ranges[i].first <= lastEnd){
+                GLuint end = std::max(lastEnd, ranges[i].first + ranges[i].count);
+                ranges[last].count = end - ranges[last].first;
+            }
+            else {
+                ranges[++last] = ranges[i];
+            }
+        }
+        ranges.resize(last + 1);
+    }
+    
+    void PrimitiveDrawer::UploadDirtyRanges(){
+        CoalesceRanges(dirtyRanges);
+        if(!isStreaming){
+            if(dirtyRanges.empty()){
+                return;
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, vbo);
+            for(auto& range : dirtyRanges){
+                glBufferSubData(GL_ARRAY_BUFFER, range.first * sizeof(Vertex), range.count * sizeof(Vertex), &vertexShadow[range.first]);
+            }
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            dirtyRanges.clear();
+            return;
+        }
+        
+        //どの領域にも写す. 他の領域はその領域を使うフレームで写す
+        for(auto& pending : streamPending){
+            pending.insert(pending.end(), dirtyRanges.begin(), dirtyRanges.end());
+        }
+        dirtyRanges.clear();
+        std::vector<VertexRange>& pending = streamPending[streamRegion];
+        if(pending.empty()){
+            return;
+        }
+        WaitStreamRegion();
+        CoalesceRanges(pending);
+        Vertex* region = streamMapped + streamRegion * (streamRegionSize / sizeof(Vertex));
+        for(auto& range : pending){
+            memcpy(region + range.first, &vertexShadow[range.first], range.count * sizeof(Vertex));
+        }
+        pending.clear();
+    }
+    
+    void PrimitiveDrawer::WaitStreamRegion(){
+        GLsync& fence = streamFences[streamRegion];
+        if(!fence){
+            return;
+        }
+        GLenum result = glClientWaitSync(fence, 0, 0);
+        while(result == GL_TIMEOUT_EXPIRED){
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+        glDeleteSync(fence);
+        fence = 0;
     }
     
     void PrimitiveDrawer::Draw(const Matrix4x4& matMVP){
+        frustum = MakeFrustum(matMVP);
+        hasFrustum = true;
+        UpdateCulledMeshes();
+        if(isIndexDirty){
+            RebuildIndex();
+        }
+        UploadDirtyRanges();
+        GLint baseVertex = 0;
+        if(isStreaming){
+            baseVertex = (GLint)(streamRegion * (streamRegionSize / sizeof(Vertex)));
+        }
+        
+        //見えるメッシュの ibo の範囲を集める(続いているものは1つにまとめる)
+        drawCounts.clear();
+        drawOffsets.clear();
+        GLuint rangeEnd = 0;
+        for(auto mesh : meshes){
+            if(!IsVisible(mesh)){
+                continue;
+            }
+            if(!drawCounts.empty() && rangeEnd == mesh->iboOffset){
+                drawCounts.back() += mesh->iboCount;
+            }
+            else {
+                drawCounts.push_back(mesh->iboCount);
+                drawOffsets.push_back(reinterpret_cast<const GLvoid*>((size_t)mesh->iboOffset));
+            }
+            rangeEnd = mesh->iboOffset + mesh->iboCount * sizeof(GLuint);
+        }
+        drawBaseVertices.assign(drawCounts.size(), baseVertex);
+        
         glBindVertexArray(vao);
         glUseProgram(shader);
         glUniformMatrix4fv(matMVPLoc,1, GL_FALSE, &matMVP[0][0]);
-        switch (mode) {
-            case Mode::LineMode:
-                glDrawElements(GL_LINES, iboEnd / sizeof(GLuint), GL_UNSIGNED_INT, 0);
-                break;
-            case Mode::PolygonMode:
-                glDrawElements(GL_TRIANGLES, iboEnd / sizeof(GLuint), GL_UNSIGNED_INT, 0);
-                break;
-            default:
-                break;
+        if(!drawCounts.empty()){
+            switch (mode) {
+                case Mode::LineMode:
+                    glMultiDrawElementsBaseVertex(GL_LINES, drawCounts.data(), GL_UNSIGNED_INT, drawOffsets.data(),
+                                                  (GLsizei)drawCounts.size(), drawBaseVertices.data());
+                    break;
+                case Mode::PolygonMode:
+                    glMultiDrawElementsBaseVertex(GL_TRIANGLES, drawCounts.data(), GL_UNSIGNED_INT, drawOffsets.data(),
+                                                  (GLsizei)drawCounts.size(), drawBaseVertices.data());
+                    break;
+                default:
+                    break;
+            }
         }
         glBindVertexArray(0);
+        DrawInstances(matMVP);
+        
+        if(isStreaming){
+            //この領域は GPU が読み終わるまで書かない
+            if(streamFences[streamRegion]){
+                glDeleteSync(streamFences[streamRegion]);
+            }
+            streamFences[streamRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            streamRegion = (streamRegion + 1) % streamRegionNum;
+        }
     }
     
-    void PrimitiveDrawer::LineMode(){
-        mode = Mode::LineMode;
-        // TODO: iboの書き換え
-        iboEnd = 0;
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-        std::vector<GLuint> indices;
-        for(auto& mesh : meshes){
-            iboEnd = mesh->vboOffset / sizeof(Vertex);
-            std::vector<GLuint> index = mesh->LineDrawMode();
-            for(int i = 0; i < index.size(); ++i){
-                indices.push_back(index[i] + iboEnd);
-            }
-            mesh->iboOffset = iboEnd;
+    void PrimitiveDrawer::DrawInstances(const Matrix4x4& matMVP){
+        if(instanceBatches.empty()){
+            return;
         }
+        //映る半径(ピクセル) = radius * |2行目の xyz| / w * 画面の高さの半分
+        Matrix4x4 mat = matMVP;
+        Vector4 rowY = mat.row(1);
+        lodRowW = mat.row(3);
+        lodPixelScale = sqrtf(rowY.x * rowY.x + rowY.y * rowY.y + rowY.z * rowY.z) * lodScreenHeight * 0.5f;
         
-        iboEnd = (GLuint)indices.size() * sizeof(GLuint);
-        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, iboEnd, indices.data());
-        
-        glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
+        GLenum primitive = mode == Mode::LineMode ? GL_LINES : GL_TRIANGLES;
+        glUseProgram(instanceShader);
+        glUniformMatrix4fv(instanceMatMVPLoc,1, GL_FALSE, &matMVP[0][0]);
+        for(auto& batch : instanceBatches){
+            //見えている1体ごとに位置・向き・色だけを, 選んだ段に送る(前のフレームの中身は捨てる)
+            for(auto& level : batch.levels){
+                level.instances.clear();
+            }
+            Vector3 center;
+            float radius;
+            for(auto mesh : batch.meshes){
+                mesh->GetBoundingSphere(center, radius);
+                if(hasFrustum && !frustum.IsVisible(center, radius)){
+                    continue;
+                }
+                mesh->lodLevel = SelectLOD(batch, mesh, center, radius);
+                batch.levels[mesh->lodLevel].instances.push_back(mesh->GetInstance());
+            }
+            for(auto& level : batch.levels){
+                if(level.instances.empty()){
+                    continue;
+                }
+                glBindBuffer(GL_ARRAY_BUFFER, level.instanceVbo);
+                glBufferData(GL_ARRAY_BUFFER, level.instances.size() * sizeof(MeshInstance), level.instances.data(), GL_STREAM_DRAW);
+                glBindVertexArray(level.vao);
+                glDrawElementsInstanced(primitive, level.indexNum, GL_UNSIGNED_INT, 0, (GLsizei)level.instances.size());
+            }
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+    
+    void PrimitiveDrawer::SetLOD(bool isEnabled, float screenHeight, float edgePixels, float hysteresis){
+        isLOD = isEnabled;
+        lodScreenHeight = screenHeight;
+        lodEdgePixels = edgePixels;
+        lodHysteresis = hysteresis;
+    }
+    
+    int PrimitiveDrawer::SelectLOD(const InstanceBatch& batch, PrimitiveMesh* mesh, const Vector3& center, float radius) const {
+        if(!isLOD || batch.levels.size() == 1){
+            return 0;
+        }
+        float w = lodRowW.x * center.x + lodRowW.y * center.y + lodRowW.z * center.z + lodRowW.w;
+        //カメラが球の中かすぐ近く
+        if(w <= radius){
+            return 0;
+        }
+        float pixels = radius * lodPixelScale / w;
+        int current = std::min(mesh->lodLevel, (int)batch.levels.size() - 1);
+        //少し近づいても・離れても今の段で足りるなら変えない
+        int finer = SelectLODLevel(batch, pixels * (1.0f + lodHysteresis));
+        int coarser = SelectLODLevel(batch, pixels * (1.0f - lodHysteresis));
+        if(finer <= current && current <= coarser){
+            return current;
+        }
+        return SelectLODLevel(batch, pixels);
+    }
+    
+    int PrimitiveDrawer::SelectLODLevel(const InstanceBatch& batch, float pixels) const {
+        //周りは divideNum * 4 本の辺なので, 1辺はおよそ pi * pixels / (2 * divideNum)
+        float needDivide = M_PI * pixels / (2.0f * lodEdgePixels);
+        int level = 0;
+        while(level + 1 < batch.levels.size() && batch.levels[level + 1].divideNum >= needDivide){
+            ++level;
+        }
+        return level;
+    }
+    
+    void PrimitiveDrawer::LineMode(){
+        mode = Mode::LineMode;
+        RebuildIndex();
     }
     
     void PrimitiveDrawer::PolygonMode(){
         mode = Mode::PolygonMode;
-        // TODO: iboの書き換え
-        iboEnd = 0;
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-        std::vector<GLuint> indices;
-        for(auto& mesh : meshes){
-            iboEnd = mesh->vboOffset / sizeof(Vertex);
-            std::vector<GLuint> index = mesh->SurfaceDrawMode();
-            for(int i = 0; i < index.size(); ++i){
-                indices.push_back(index[i] + iboEnd);
-            }
-            mesh->iboOffset = iboEnd;
-        }
-        
-        iboEnd = (GLuint)indices.size() * sizeof(GLuint);
-        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, iboEnd, indices.data());
-        
-        glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
-        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
+        RebuildIndex();
         
         //        iboEnd = 0;
         //        GLuint vboIdx = 0;
@@ -847,5 +1360,30 @@ namespace myTools {
         //        glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
         //        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
     }
+    
+    void PrimitiveDrawer::RebuildIndex(){
+        isIndexDirty = false;
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+        std::vector<GLuint> indices;
+        for(auto& mesh : meshes){
+            GLuint vboIdx = mesh->vboOffset / sizeof(Vertex);
+            std::vector<GLuint>& index = mode == Mode::LineMode ? mesh->LineDrawMode() : mesh->SurfaceDrawMode();
+            mesh->iboOffset = (GLuint)(indices.size() * sizeof(GLuint));
+            mesh->iboCount = (GLsizei)index.size();
+            for(int i = 0; i < index.size(); ++i){
+                indices.push_back(index[i] + vboIdx);
+            }
+        }
+        
+        iboEnd = (GLuint)indices.size() * sizeof(GLuint);
+        glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, iboEnd, indices.data());
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,0);
+        
+        for(auto& batch : instanceBatches){
+            for(auto& level : batch.levels){
+                SetInstanceIndex(level);
+            }
+        }
+    }
 }
 
@@ -12,6 +12,8 @@
 #include "Vector.h"
 #include "Matrix.h"
 #include "Primitive.h"
+#include "Quaternion.h"
+#include "Frustum.h"
 #include <vector>
 #include <GL/glew.h>
 
@@ -23,29 +25,100 @@ namespace myTools {
         Vector4 color;
     };
     
+    /**
+     *  @tips   Per-instance data for instanced drawing.
+     *          Template vertices are scaled by radius, vertices with w = 1 get length added to y,
+     *          then they are rotated by rotation and placed at position
+     */
+    struct MeshInstance{
+        Quaternion rotation;
+        Vector3 position;
+        float radius = 1.0f;
+        float length = 0.0f;
+        Vector4 color;
+    };
+    
     class PrimitiveDrawer;
     
     class PrimitiveMesh{
         friend PrimitiveDrawer;
     public:
+        enum class InstanceShape{
+            None,
+            Sphere,
+            Capsule,
+        };
+        
+        //前に送ってから変わったところ. PrimitiveDrawer::Update は何か変わったメッシュだけ送る
+        enum DirtyFlag : unsigned int {
+            DirtyNone = 0,
+            DirtyTransform = 1 << 0,
+            DirtyColor = 1 << 1,
+            //インデックスを作り直す. 分割数は作るときに決まる(SetDivideNum は private)ので, AddMesh の後に頂点数は変わらない
+            DirtyTopology = 1 << 2,
+            DirtyAll = DirtyTransform | DirtyColor | DirtyTopology,
+        };
+        
         virtual ~PrimitiveMesh() = default;
         virtual std::vector<Vertex> Update();
         
         virtual unsigned int VertexNum() = 0;
         
         void SetColor(const Vector4& color){
-            this->color = color;
+            if(!(this->color == color)){
+                this->color = color;
+                SetDirty(DirtyColor);
+            }
+        }
+        unsigned int GetDirty() const {
+            return dirty;
         }
     protected:
+        void SetDirty(unsigned int flag){
+            dirty |= flag;
+        }
+        
         virtual std::vector<GLuint>& LineDrawMode() = 0;
         virtual std::vector<GLuint>& SurfaceDrawMode() = 0;
         
+        //インスタンス描画(PrimitiveDrawer::AddInstance)に使う. 使えない形は None
+        virtual InstanceShape GetInstanceShape() const {
+            return InstanceShape::None;
+        }
+        //半径 1, 長さ 0 の形の頂点. w が 1 の頂点は長さの分だけずらす
+        virtual std::vector<Vector4> InstanceTemplate(){
+            return std::vector<Vector4>();
+        }
+        virtual MeshInstance GetInstance(){
+            MeshInstance instance;
+            instance.color = color;
+            return instance;
+        }
+        //視錐台カリングに使う外接球. 頂点を作らずに今の設定から出す(基本は vert から)
+        virtual void GetBoundingSphere(Vector3& center, float& radius);
+        /**
+         *  @tips   Create (with new) the same shape with 1/2^level of the divide number for LOD (level 0 keeps it).
+         *          divideNum receives that divide number. Returns nullptr if there is no LOD
+         */
+        virtual PrimitiveMesh* CreateLOD(int, unsigned int&){
+            return nullptr;
+        }
+        
         std::vector<Vector3> vert;
         Vector4 color;
 
     private:
         GLuint vboOffset;
         GLuint iboOffset;
+        bool isInstanced = false;
+        unsigned int dirty = DirtyAll;
+        //vbo に取った頂点数
+        unsigned int vboVertexNum = 0;
+        GLsizei iboCount = 0;
+        //見えなかったので Update を後回しにしている
+        bool isCullDeferred = false;
+        //前のフレームで描いた LOD の段
+        int lodLevel = 0;
     };
     
     class LineMesh : public PrimitiveMesh {
@@ -106,9 +179,11 @@ namespace myTools {
     public:
         void SetRadius(const float& radius){
             this->radius = radius;
+            SetDirty(DirtyTransform);
         }
         void SetDivideNum(const GLuint& divideNum){
             this->divideNum = divideNum;
+            SetDirty(DirtyTopology);
         }
         
         std::vector<Vertex> Update() override;
@@ -130,6 +205,7 @@ namespace myTools {
         
         void SetPosition(const Vector3& position){
             this->position = position;
+            SetDirty(DirtyTransform);
         }
         std::vector<Vertex> Update() override;
         unsigned int VertexNum() override {
@@ -139,10 +215,17 @@ namespace myTools {
         void SetDivideNum(int num);
         std::vector<GLuint>& LineDrawMode() override;
         std::vector<GLuint>& SurfaceDrawMode() override;
+        InstanceShape GetInstanceShape() const override {
+            return InstanceShape::Sphere;
+        }
+        std::vector<Vector4> InstanceTemplate() override;
+        MeshInstance GetInstance() override;
+        void GetBoundingSphere(Vector3& center, float& radius) override;
+        PrimitiveMesh* CreateLOD(int level, unsigned int& divideNum) override;
         
         std::vector<GLuint> index;
         float radius = 1.0f;
-        unsigned int divideNum;
+        unsigned int divideNum = 0;
         
         int topIndex = 0;
         int bottomIndex = 0;
@@ -160,7 +243,7 @@ namespace myTools {
         unsigned int VertexNum() override ;
     private:
         void SetDivideNum(unsigned int num);
-        unsigned int divideNum;
+        unsigned int divideNum = 0;
         unsigned int sphereHalfIndex;
         int topIndex = 0;
         int bottomIndex = 0;
@@ -168,6 +251,13 @@ namespace myTools {
         Segment segment;
         std::vector<GLuint>& LineDrawMode() override;
         std::vector<GLuint>& SurfaceDrawMode() override;
+        InstanceShape GetInstanceShape() const override {
+            return InstanceShape::Capsule;
+        }
+        std::vector<Vector4> InstanceTemplate() override;
+        MeshInstance GetInstance() override;
+        void GetBoundingSphere(Vector3& center, float& radius) override;
+        PrimitiveMesh* CreateLOD(int level, unsigned int& divideNum) override;
         
         std::vector<GLuint> index;
     };
@@ -177,9 +267,11 @@ namespace myTools {
         Cube();
         void SetScale(const Vector3& s){
             scale = s;
+            SetDirty(DirtyTransform);
         }
         void SetPosition(const Vector3& pos){
             position = pos;
+            SetDirty(DirtyTransform);
         }
         unsigned int VertexNum() override {
             return vertexNum;
@@ -193,6 +285,7 @@ namespace myTools {
         
         std::vector<GLuint>& LineDrawMode() override;
         std::vector<GLuint>& SurfaceDrawMode() override;
+        void GetBoundingSphere(Vector3& center, float& radius) override;
         
         Vector3 scale;
         Vector3 position;
@@ -208,9 +301,27 @@ namespace myTools {
         static PrimitiveDrawer& Instance();
         bool Init();
         void AddMesh(PrimitiveMesh* mesh);
+        /**
+         *  @tips   Draw Sphere / CapsuleMesh with one template per shape and divide number.
+         *          Only position, rotation and colour are gathered and sent at each Draw, so no Update is needed.
+         *          Shapes that cannot be instanced are the same as AddMesh
+         */
+        void AddInstance(PrimitiveMesh* mesh);
+        /**
+         *  @tips   Rebuild and send the vertices of a changed mesh. The vertex count is fixed once the mesh is added.
+         *          Meshes outside the frustum of the last Draw are deferred until a Draw where they are inside
+         */
         void Update(PrimitiveMesh* mesh);
+        //matMVP (Perspective * ViewMat) の視錐台にかかるメッシュだけを描く
         void Draw(const Matrix4x4& matMVP);
         
+        /**
+         *  @tips   LOD for meshes added by AddInstance. From the projected radius on a screenHeight pixel screen,
+         *          the coarsest level whose outline edges are about edgePixels or shorter is selected.
+         *          The level is kept until the projected radius changes by more than hysteresis (0 reselects every time)
+         */
+        void SetLOD(bool isEnabled, float screenHeight, float edgePixels = 8.0f, float hysteresis = 0.2f);
+        
         void LineMode();
         void PolygonMode();
         
@@ -220,7 +331,52 @@ namespace myTools {
         PrimitiveDrawer(const PrimitiveDrawer&) = delete;
         PrimitiveDrawer& operator=(const PrimitiveDrawer) = delete;
         
+        //LOD の1段. prototype はこの段の分割数で作った形(テンプレートとインデックスに使う)
+        struct InstanceLevel{
+            PrimitiveMesh* prototype = nullptr;
+            unsigned int divideNum = 0;
+            std::vector<MeshInstance> instances;
+            GLuint templateVbo = 0;
+            GLuint instanceVbo = 0;
+            GLuint ibo = 0;
+            GLuint vao = 0;
+            GLsizei indexNum = 0;
+        };
+        //同じ形・同じ頂点数のメッシュをまとめたもの. levels[0] が一番細かい
+        struct InstanceBatch{
+            PrimitiveMesh::InstanceShape shape;
+            unsigned int vertexNum = 0;
+            std::vector<PrimitiveMesh*> meshes;
+            std::vector<InstanceLevel> levels;
+        };
+        static const int maxLODLevelNum = 4;
+        bool CreateInstanceLevel(InstanceLevel& level);
+        void SetInstanceIndex(InstanceLevel& level);
+        void DrawInstances(const Matrix4x4& matMVP);
+        //中心 center, 半径 radius のメッシュを描く段
+        int SelectLOD(const InstanceBatch& batch, PrimitiveMesh* mesh, const Vector3& center, float radius) const;
+        //SelectLOD 用. 映る半径 pixels で足りる一番粗い段
+        int SelectLODLevel(const InstanceBatch& batch, float pixels) const;
+        
+        //頂点の番号で表した vbo の範囲
+        struct VertexRange{
+            GLuint first;
+            GLuint count;
+        };
+        //並べて, 重なる・隣り合う範囲を1つにつなげる
+        static void CoalesceRanges(std::vector<VertexRange>& ranges);
+        //Update で変わった範囲だけを vertexShadow から vbo に送る
+        void UploadDirtyRanges();
+        //今のフレームの領域を GPU が読み終わるまで待つ
+        void WaitStreamRegion();
+        //今の mode で ibo を作り直す
+        void RebuildIndex();
+        bool IsVisible(PrimitiveMesh* mesh) const;
+        //後回しにしたメッシュのうち, 視錐台に入ったものを Update する
+        void UpdateCulledMeshes();
+        
         std::vector<PrimitiveMesh*> meshes;
+        std::vector<InstanceBatch> instanceBatches;
         
         Mode mode = Mode::LineMode;
         
@@ -229,10 +385,49 @@ namespace myTools {
         
         GLuint vbo = 0;
         GLuint ibo = 0;
+        
+        //vbo と同じ頂点の CPU 側の写し. 色だけ変わったときはここを直接書き換える
+        std::vector<Vertex> vertexShadow;
+        //このフレームで Update された範囲
+        std::vector<VertexRange> dirtyRanges;
+        bool isIndexDirty = false;
+        
+        //前の Draw の視錐台
+        Frustum frustum;
+        bool hasFrustum = false;
+        
+        bool isLOD = true;
+        float lodScreenHeight = 600.0f;
+        float lodEdgePixels = 8.0f;
+        float lodHysteresis = 0.2f;
+        //Draw の matMVP の4行目(w)と, 半径を映る半径(ピクセル)にする係数
+        Vector4 lodRowW;
+        float lodPixelScale = 0.0f;
+        std::vector<PrimitiveMesh*> culledMeshes;
+        //glMultiDrawElementsBaseVertex に渡す, 見えるメッシュが続く ibo の範囲
+        std::vector<GLsizei> drawCounts;
+        std::vector<const GLvoid*> drawOffsets;
+        std::vector<GLint> drawBaseVertices;
+        
+        /**
+         *  @tips   With GL_ARB_buffer_storage the vbo is split into three persistently mapped regions
+         *          used in turn, one per frame (otherwise glBufferSubData).
+         *          Changed ranges are copied from vertexShadow in the Draw of each region's frame
+         */
+        static const int streamRegionNum = 3;
+        bool isStreaming = false;
+        Vertex* streamMapped = nullptr;
+        GLsizeiptr streamRegionSize = 0;
+        int streamRegion = 0;
+        GLsync streamFences[streamRegionNum] = {};
+        std::vector<VertexRange> streamPending[streamRegionNum];
         GLuint vao = 0;
         GLuint shader = 0;
         
         GLint matMVPLoc = -1;
+        
+        GLuint instanceShader = 0;
+        GLint instanceMatMVPLoc = -1;
     };
 }
 
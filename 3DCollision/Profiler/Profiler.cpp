@@ -0,0 +1,173 @@
+//
+//  Profiler.cpp
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/02/02.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+
+namespace myTools {
+
+    namespace {
+        typedef std::chrono::steady_clock Clock;
+        const Clock::time_point startTime = Clock::now();
+
+        thread_local void* threadBuffer = nullptr;
+
+        //JSON に入れられない文字は書かない
+        void WriteEscaped(std::ostream& stream, const char* text){
+            for(; *text; ++text){
+                if(*text == '"' || *text == '\\'){
+                    stream << '\\';
+                }
+                if((unsigned char)*text >= 0x20){
+                    stream << *text;
+                }
+            }
+        }
+    }
+
+    Profiler& Profiler::Instance(){
+        static Profiler profiler;
+        return profiler;
+    }
+
+    Profiler::Profiler(){
+        frameBegin = Now();
+    }
+
+    void Profiler::SetCapacity(int eventCount){
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        capacity = std::max(eventCount, 1);
+    }
+
+    int64_t Profiler::Now() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startTime).count();
+    }
+
+    Profiler::ThreadBuffer& Profiler::GetThreadBuffer(){
+        if(!threadBuffer){
+            //スレッドごとに最初の1回だけ
+            std::lock_guard<std::mutex> lock(buffersMutex);
+            std::unique_ptr<ThreadBuffer> buffer(new ThreadBuffer());
+            buffer->events.resize(capacity);
+            buffer->threadId = (int)buffers.size();
+            threadBuffer = buffer.get();
+            buffers.push_back(std::move(buffer));
+        }
+        return *static_cast<ThreadBuffer*>(threadBuffer);
+    }
+
+    void Profiler::Record(const char* name, int64_t begin, int64_t end, uint32_t frame){
+        ThreadBuffer& buffer = GetThreadBuffer();
+        uint64_t head = buffer.head.load(std::memory_order_relaxed);
+        Event& event = buffer.events[head % buffer.events.size()];
+        event.name = name;
+        event.begin = begin;
+        event.end = end;
+        event.frame = frame;
+        buffer.head.store(head + 1, std::memory_order_release);
+    }
+
+    void Profiler::EndFrame(){
+        int64_t now = Now();
+        lastFrame.frame = frame.load(std::memory_order_relaxed);
+        lastFrame.begin = frameBegin;
+        lastFrame.end = now;
+        hasLastFrame = true;
+        frameBegin = now;
+        frame.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    template<typename Func>
+    void Profiler::ForEachEvent(const Func& func) const {
+        std::lock_guard<std::mutex> lock(buffersMutex);
+        for(const auto& buffer : buffers){
+            uint64_t head = buffer->head.load(std::memory_order_acquire);
+            uint64_t size = buffer->events.size();
+            uint64_t first = head > size ? head - size : 0;
+            for(uint64_t i = first; i < head; ++i){
+                func(buffer->threadId, buffer->events[i % size]);
+            }
+        }
+    }
+
+    bool Profiler::GetFrameSummary(FrameSummary& summary) const {
+        summary.zones.clear();
+        if(!hasLastFrame){
+            return false;
+        }
+        summary.frame = lastFrame.frame;
+        summary.frameMs = (lastFrame.end - lastFrame.begin) * 1e-6;
+
+        std::vector<int64_t> firstBegin;
+        ForEachEvent([&](int, const Event& event){
+            if(event.frame != lastFrame.frame){
+                return;
+            }
+            double ms = (event.end - event.begin) * 1e-6;
+            for(int i = 0; i < summary.zones.size(); ++i){
+                ZoneSummary& zone = summary.zones[i];
+                if(zone.name == event.name || strcmp(zone.name, event.name) == 0){
+                    ++zone.count;
+                    zone.totalMs += ms;
+                    zone.maxMs = std::max(zone.maxMs, ms);
+                    firstBegin[i] = std::min(firstBegin[i], event.begin);
+                    return;
+                }
+            }
+            summary.zones.push_back({event.name, 1, ms, ms});
+            firstBegin.push_back(event.begin);
+        });
+
+        //始まった順に並べる
+        std::vector<int> order(summary.zones.size());
+        for(int i = 0; i < order.size(); ++i){
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](int lhs, int rhs){
+            return firstBegin[lhs] < firstBegin[rhs];
+        });
+        std::vector<ZoneSummary> zones;
+        zones.reserve(order.size());
+        for(int index : order){
+            zones.push_back(summary.zones[index]);
+        }
+        summary.zones.swap(zones);
+        return true;
+    }
+
+    void Profiler::WriteChromeTrace(std::ostream& stream) const {
+        //ts, dur はマイクロ秒
+        stream << "{\"traceEvents\":[\n";
+        bool isFirst = true;
+        ForEachEvent([&](int threadId, const Event& event){
+            if(!isFirst){
+                stream << ",\n";
+            }
+            isFirst = false;
+            stream << "{\"name\":\"";
+            WriteEscaped(stream, event.name);
+            stream << "\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":0,\"tid\":" << threadId
+                   << ",\"ts\":" << event.begin / 1000 << '.' << (event.begin % 1000) / 100
+                   << ",\"dur\":" << (event.end - event.begin) / 1000 << '.' << ((event.end - event.begin) % 1000) / 100
+                   << ",\"args\":{\"frame\":" << event.frame << "}}";
+        });
+        stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    }
+
+    bool Profiler::WriteChromeTrace(const char* path) const {
+        std::ofstream file(path);
+        if(!file){
+            return false;
+        }
+        WriteChromeTrace(file);
+        return (bool)file;
+    }
+}// namespace myTools
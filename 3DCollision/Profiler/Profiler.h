@@ -0,0 +1,166 @@
+//
+//  Profiler.h
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/02/02.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#ifndef Profiler_h
+#define Profiler_h
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+//  MT_NO_PROFILE を定義すると PROFILE_ZONE は何もしない
+#if defined(MT_NO_PROFILE)
+#   define PROFILE_ZONE(name)
+#else
+#   define PROFILE_ZONE_CONCAT2(a, b) a##b
+#   define PROFILE_ZONE_CONCAT(a, b) PROFILE_ZONE_CONCAT2(a, b)
+#   define PROFILE_ZONE(name) myTools::ProfileZone PROFILE_ZONE_CONCAT(profileZone, __LINE__)(name)
+#endif
+
+namespace myTools {
+
+    /**
+     *  @tips   Records how long each zone takes.
+     *          Each thread writes only to its own ring buffer, so recording takes no lock.
+     *          The oldest events are overwritten.
+     *          Call GetFrameSummary / WriteChromeTrace while no zone is running (e.g. between frames).
+     */
+    class Profiler {
+    public:
+        struct Event {
+            //文字列リテラルを渡すこと(ポインタだけ保持する)
+            const char* name;
+            //Profiler を作ってからの時間(ナノ秒)
+            int64_t begin;
+            int64_t end;
+            uint32_t frame;
+        };
+
+        struct ZoneSummary {
+            const char* name;
+            int count;
+            //全スレッドの合計
+            double totalMs;
+            //1回の最大
+            double maxMs;
+        };
+
+        struct FrameSummary {
+            uint32_t frame = 0;
+            double frameMs = 0.0;
+            //最初に始まった順
+            std::vector<ZoneSummary> zones;
+        };
+
+        static Profiler& Instance();
+
+        void SetEnabled(bool isEnabled){
+            enabled.store(isEnabled, std::memory_order_relaxed);
+        }
+        bool IsEnabled() const {
+            return enabled.load(std::memory_order_relaxed);
+        }
+        /**
+         *  @tips   Events kept per thread. Only affects threads that record for the first time afterwards.
+         */
+        void SetCapacity(int eventCount);
+
+        /**
+         *  @tips   Close the current frame. Call once per frame from the main loop.
+         */
+        void EndFrame();
+        uint32_t GetFrame() const {
+            return frame.load(std::memory_order_relaxed);
+        }
+
+        /**
+         *  @tips   Summary of the last frame closed by EndFrame.
+         *          Returns false if no frame has been closed yet.
+         */
+        bool GetFrameSummary(FrameSummary& summary) const;
+
+        /**
+         *  @tips   Every event still in the ring buffers as Chrome trace_event JSON
+         *          (chrome://tracing, Perfetto). tid is the order threads first recorded.
+         */
+        void WriteChromeTrace(std::ostream& stream) const;
+        bool WriteChromeTrace(const char* path) const;
+
+        //今の時間(ナノ秒)
+        int64_t Now() const;
+        void Record(const char* name, int64_t begin, int64_t end, uint32_t frame);
+
+    private:
+        struct ThreadBuffer {
+            std::vector<Event> events;
+            //今までに書いた数. events.size() で割った余りが次の書き込み位置
+            std::atomic<uint64_t> head{0};
+            int threadId;
+        };
+        //閉じたフレームの範囲
+        struct FrameRecord {
+            uint32_t frame;
+            int64_t begin;
+            int64_t end;
+        };
+
+        Profiler();
+        Profiler(const Profiler&) = delete;
+        Profiler& operator=(const Profiler&) = delete;
+
+        ThreadBuffer& GetThreadBuffer();
+        template<typename Func>
+        void ForEachEvent(const Func& func) const;
+
+        std::atomic<bool> enabled{true};
+        std::atomic<uint32_t> frame{0};
+        int capacity = 1 << 14;
+        int64_t frameBegin = 0;
+        FrameRecord lastFrame = {0, 0, 0};
+        bool hasLastFrame = false;
+
+        mutable std::mutex buffersMutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    };
+
+    /**
+     *  @tips   Records one zone from construction to destruction.
+     *          Use it through the macro, e.g. PROFILE_ZONE("CulcFix");
+     */
+    class ProfileZone {
+    public:
+        explicit ProfileZone(const char* name) : name(name){
+            Profiler& profiler = Profiler::Instance();
+            if(profiler.IsEnabled()){
+                frame = profiler.GetFrame();
+                begin = profiler.Now();
+            }
+            else {
+                this->name = nullptr;
+            }
+        }
+        ~ProfileZone(){
+            if(name){
+                Profiler& profiler = Profiler::Instance();
+                profiler.Record(name, begin, profiler.Now(), frame);
+            }
+        }
+        ProfileZone(const ProfileZone&) = delete;
+        ProfileZone& operator=(const ProfileZone&) = delete;
+
+    private:
+        const char* name;
+        int64_t begin = 0;
+        uint32_t frame = 0;
+    };
+}// namespace myTools
+
+#endif /* Profiler_h */
@@ -0,0 +1,318 @@
+//
+//  RayCastBatch.cpp
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/02/08.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#include "RayCastBatch.h"
+#include "World.h"
+#include "JobSystem.h"
+#include <math.h>
+
+namespace myTools {
+
+    namespace {
+        //これより短い向きの成分は軸に平行とみなす
+        const float RayParallelEpsilon = 1.0e-12f;
+
+        //始点が形状の中にあるとき
+        void SetInside(const Segment& ray, float& t, Vector3& normal){
+            t = 0.0f;
+            normal = -Normalize(ray.v);
+        }
+
+        //箱の中の座標で見たレイと箱 [min, max]. axis は入った面の軸(始点が中なら -1)
+        bool RaySlab(const Vector3& origin, const Vector3& dir, const Vector3& min, const Vector3& max,
+                     float tMax, float& t, int& axis){
+            float tNear = 0.0f;
+            float tFar = tMax;
+            axis = -1;
+            for(int i = 0; i < 3; ++i){
+                if(fabsf(dir[i]) < RayParallelEpsilon){
+                    if(origin[i] < min[i] || origin[i] > max[i]){
+                        return false;
+                    }
+                    continue;
+                }
+                float invDir = 1.0f / dir[i];
+                float t1 = (min[i] - origin[i]) * invDir;
+                float t2 = (max[i] - origin[i]) * invDir;
+                if(t1 > t2){
+                    float tmp = t1;
+                    t1 = t2;
+                    t2 = tmp;
+                }
+                if(t1 > tNear){
+                    tNear = t1;
+                    axis = i;
+                }
+                tFar = fminf(tFar, t2);
+                if(tNear > tFar){
+                    return false;
+                }
+            }
+            t = tNear;
+            return true;
+        }
+
+        bool RaySphere(const Segment& ray, const Vector3& center, float radius, float tMax, float& t, Vector3& normal){
+            Vector3 m = ray.p - center;
+            float c = m.LengthSq() - radius * radius;
+            if(c <= 0.0f){
+                SetInside(ray, t, normal);
+                return true;
+            }
+            float a = ray.v.LengthSq();
+            float b = dot(m, ray.v);
+            //離れていく向き
+            if(b > 0.0f || a == 0.0f){
+                return false;
+            }
+            float disc = b * b - a * c;
+            if(disc < 0.0f){
+                return false;
+            }
+            t = (-b - sqrtf(disc)) / a;
+            if(t > tMax){
+                return false;
+            }
+            normal = (m + ray.v * t) / radius;
+            return true;
+        }
+
+        bool RayCapsule(const Segment& ray, const CapsuleCollision& capsule, float tMax, float& t, Vector3& normal){
+            const Segment& axis = capsule.s;
+            float radius = capsule.radius;
+            float pointT;
+            Vector3 nearest;
+            if(SupPointSegmentDistSq(ray.p, axis, pointT, nearest) <= radius * radius){
+                SetInside(ray, t, normal);
+                return true;
+            }
+            //筒の側面(軸の範囲に入っているときだけ)
+            Vector3 m = ray.p - axis.p;
+            float dd = axis.v.LengthSq();
+            float md = dot(m, axis.v);
+            float nd = dot(ray.v, axis.v);
+            float a = dd * ray.v.LengthSq() - nd * nd;
+            bool isHit = false;
+            if(dd > 0.0f && fabsf(a) > RayParallelEpsilon * dd){
+                float b = dd * dot(m, ray.v) - nd * md;
+                float c = dd * (m.LengthSq() - radius * radius) - md * md;
+                float disc = b * b - a * c;
+                if(disc >= 0.0f){
+                    float sideT = (-b - sqrtf(disc)) / a;
+                    float along = md + sideT * nd;
+                    if(0.0f <= sideT && sideT <= tMax && 0.0f <= along && along <= dd){
+                        Vector3 hitPos = ray.p + ray.v * sideT;
+                        t = sideT;
+                        normal = (hitPos - (axis.p + axis.v * (along / dd))) / radius;
+                        isHit = true;
+                    }
+                }
+            }
+            if(isHit){
+                return true;
+            }
+            //両端の球
+            float sphereT;
+            Vector3 sphereNormal;
+            if(RaySphere(ray, axis.p, radius, tMax, sphereT, sphereNormal)){
+                t = sphereT;
+                normal = sphereNormal;
+                tMax = sphereT;
+                isHit = true;
+            }
+            if(RaySphere(ray, axis.GetEndPoint(), radius, tMax, sphereT, sphereNormal)){
+                t = sphereT;
+                normal = sphereNormal;
+                isHit = true;
+            }
+            return isHit;
+        }
+
+        bool RayBox(const Segment& ray, const AABBCollision& box, float tMax, float& t, Vector3& normal){
+            int axis;
+            if(!RaySlab(ray.p, ray.v, box.min, box.max, tMax, t, axis)){
+                return false;
+            }
+            if(axis < 0){
+                SetInside(ray, t, normal);
+                return true;
+            }
+            normal = Vector3();
+            normal[axis] = ray.v[axis] > 0.0f ? -1.0f : 1.0f;
+            return true;
+        }
+
+        bool RayCube(const Segment& ray, const CubeCollision& cube, float tMax, float& t, Vector3& normal){
+            Vector3 toOrigin = ray.p - cube.position;
+            Vector3 origin, dir;
+            for(int i = 0; i < 3; ++i){
+                origin[i] = dot(toOrigin, cube.direct[i]);
+                dir[i] = dot(ray.v, cube.direct[i]);
+            }
+            int axis;
+            if(!RaySlab(origin, dir, -cube.scale, cube.scale, tMax, t, axis)){
+                return false;
+            }
+            if(axis < 0){
+                SetInside(ray, t, normal);
+                return true;
+            }
+            normal = dir[axis] > 0.0f ? -cube.direct[axis] : cube.direct[axis];
+            return true;
+        }
+    }
+
+    void RayCastBatch::Build(const World& world){
+        const std::vector<MoveCollData<SphereCollision>>& sphereDatas = world.GetSpheres();
+        const std::vector<MoveCollData<CapsuleCollision>>& capDatas = world.GetCapsules();
+        spheres.clear();
+        capsules.clear();
+        bodies.clear();
+        bounds.clear();
+        for(int i = 0; i < sphereDatas.size(); ++i){
+            const SphereCollision& sphere = sphereDatas[i].collision;
+            spheres.push_back(sphere);
+            bodies.push_back(sphereDatas[i].body);
+            AABBCollision bound;
+            bound.min = sphere.position - Vector3(sphere.radius, sphere.radius, sphere.radius);
+            bound.max = sphere.position + Vector3(sphere.radius, sphere.radius, sphere.radius);
+            bounds.push_back(bound);
+        }
+        for(int i = 0; i < capDatas.size(); ++i){
+            const CapsuleCollision& capsule = capDatas[i].collision;
+            capsules.push_back(capsule);
+            bodies.push_back(capDatas[i].body);
+            Vector3 end = capsule.s.GetEndPoint();
+            AABBCollision bound;
+            for(int j = 0; j < 3; ++j){
+                bound.min[j] = fminf(capsule.s.p[j], end[j]) - capsule.radius;
+                bound.max[j] = fmaxf(capsule.s.p[j], end[j]) + capsule.radius;
+            }
+            bounds.push_back(bound);
+        }
+        boxes = world.GetStaticBoxes();
+        bounds.insert(bounds.end(), boxes.begin(), boxes.end());
+        cubes = world.GetStaticCubes();
+        for(int i = 0; i < cubes.size(); ++i){
+            bounds.push_back(CastToAABB(cubes[i]));
+        }
+        bvh.Build(bounds);
+    }
+
+    void RayCastBatch::SortByOctant(std::vector<int>& order, std::vector<int>& packetStarts) const {
+        int count = (int)rays.size();
+        int octantCounts[8] = {};
+        std::vector<unsigned char> octants(count);
+        for(int i = 0; i < count; ++i){
+            const Vector3& v = rays[i].v;
+            octants[i] = (v.x < 0.0f ? 1 : 0) | (v.y < 0.0f ? 2 : 0) | (v.z < 0.0f ? 4 : 0);
+            ++octantCounts[octants[i]];
+        }
+        //同じ向きのレイの中で packetSize 本ずつに区切る
+        int octantStarts[8];
+        int start = 0;
+        packetStarts.clear();
+        for(int i = 0; i < 8; ++i){
+            octantStarts[i] = start;
+            for(int first = start; first < start + octantCounts[i]; first += packetSize){
+                packetStarts.push_back(first);
+            }
+            start += octantCounts[i];
+        }
+        packetStarts.push_back(count);
+        order.resize(count);
+        for(int i = 0; i < count; ++i){
+            order[octantStarts[octants[i]]++] = i;
+        }
+    }
+
+    void RayCastBatch::CastPacket(const int* rayIndices, int count, std::vector<RayHit>& results) const {
+        Segment packet[packetSize];
+        float tMax[packetSize];
+        RayHit hits[packetSize];
+        for(int i = 0; i < count; ++i){
+            packet[i] = rays[rayIndices[i]];
+            tMax[i] = 1.0f;
+        }
+        int sphereEnd = (int)spheres.size();
+        int capsuleEnd = sphereEnd + (int)capsules.size();
+        int boxEnd = capsuleEnd + (int)boxes.size();
+        bvh.RayQuery(packet, count, tMax, [&](int index, unsigned int mask){
+            for(int i = 0; i < count; ++i){
+                if(!(mask & (1u << i))){
+                    continue;
+                }
+                float t;
+                Vector3 normal;
+                RayHit::Type type;
+                int local;
+                bool isHit;
+                if(index < sphereEnd){
+                    type = RayHit::Type::Sphere;
+                    local = index;
+                    isHit = RaySphere(packet[i], spheres[local].position, spheres[local].radius, tMax[i], t, normal);
+                }
+                else if(index < capsuleEnd){
+                    type = RayHit::Type::Capsule;
+                    local = index - sphereEnd;
+                    isHit = RayCapsule(packet[i], capsules[local], tMax[i], t, normal);
+                }
+                else if(index < boxEnd){
+                    type = RayHit::Type::Box;
+                    local = index - capsuleEnd;
+                    isHit = RayBox(packet[i], boxes[local], tMax[i], t, normal);
+                }
+                else {
+                    type = RayHit::Type::Cube;
+                    local = index - boxEnd;
+                    isHit = RayCube(packet[i], cubes[local], tMax[i], t, normal);
+                }
+                if(!isHit){
+                    continue;
+                }
+                RayHit& hit = hits[i];
+                hit.type = type;
+                hit.index = local;
+                hit.body = index < capsuleEnd ? bodies[index] : BodyHandle();
+                hit.t = t;
+                hit.normal = normal;
+                //これより遠い節は辿らない
+                tMax[i] = t;
+            }
+        });
+        for(int i = 0; i < count; ++i){
+            RayHit& hit = hits[i];
+            if(hit.type != RayHit::Type::None){
+                hit.position = packet[i].p + packet[i].v * hit.t;
+            }
+            results[rayIndices[i]] = hit;
+        }
+    }
+
+    void RayCastBatch::Cast(std::vector<RayHit>& results) const {
+        results.resize(rays.size());
+        std::vector<int> order;
+        std::vector<int> packetStarts;
+        SortByOctant(order, packetStarts);
+        for(int i = 0; i + 1 < packetStarts.size(); ++i){
+            CastPacket(order.data() + packetStarts[i], packetStarts[i + 1] - packetStarts[i], results);
+        }
+    }
+
+    void RayCastBatch::Cast(std::vector<RayHit>& results, JobSystem& jobs) const {
+        results.resize(rays.size());
+        std::vector<int> order;
+        std::vector<int> packetStarts;
+        SortByOctant(order, packetStarts);
+        jobs.ParallelFor(0, (int)packetStarts.size() - 1, 16, [&](int first, int last){
+            for(int i = first; i < last; ++i){
+                CastPacket(order.data() + packetStarts[i], packetStarts[i + 1] - packetStarts[i], results);
+            }
+        });
+    }
+}// namespace myTools
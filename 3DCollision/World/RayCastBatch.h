@@ -0,0 +1,95 @@
+//
+//  RayCastBatch.h
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/02/08.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#ifndef RayCastBatch_h
+#define RayCastBatch_h
+
+#include "Physics.h"
+#include "BodyStore.h"
+#include "StaticBVH.h"
+#include <vector>
+
+namespace myTools {
+
+    class World;
+    class JobSystem;
+
+    /**
+     *  @tips   Nearest hit of a ray (p + v * t of a Segment, t = 0 to 1).
+     *          index is into World's GetSpheres / GetCapsules / GetStaticBoxes / GetStaticCubes.
+     *          body is set only for spheres and capsules.
+     *          When the ray starts inside a shape, t is 0 and normal is opposite to the ray
+     */
+    struct RayHit {
+        enum class Type {
+            None,
+            Sphere,
+            Capsule,
+            Box,
+            Cube,
+        };
+        Type type = Type::None;
+        int index = -1;
+        BodyHandle body;
+        float t = 1.0f;
+        Vector3 position;
+        Vector3 normal;
+    };
+
+    /**
+     *  @tips   Casts many rays (line of sight, bullets) against a World at once.
+     *          Build puts spheres, capsules and static boxes into one BVH. Added rays go through it
+     *          in packets of packetSize rays with the same direction signs (StaticBVH::RayQuery).
+     *          Build copies the shapes, so call it again after the World Steps
+     */
+    class RayCastBatch {
+    public:
+        static const int packetSize = 8;
+
+        void Build(const World& world);
+
+        void Clear(){
+            rays.clear();
+        }
+        void Reserve(int count){
+            rays.reserve(count);
+        }
+        void Add(const Segment& ray){
+            rays.push_back(ray);
+        }
+        int GetCount() const {
+            return (int)rays.size();
+        }
+
+        /**
+         *  @tips   results[i] gets the nearest hit of the i-th added ray
+         */
+        void Cast(std::vector<RayHit>& results) const;
+        //組ごとにジョブに分けて計算する(結果は上と同じ)
+        void Cast(std::vector<RayHit>& results, JobSystem& jobs) const;
+
+    private:
+        //向きの符号(8通り)ごとに並べたレイの番号と, 組の先頭(最後に rays.size())
+        void SortByOctant(std::vector<int>& order, std::vector<int>& packetStarts) const;
+        void CastPacket(const int* rayIndices, int count, std::vector<RayHit>& results) const;
+
+        std::vector<SphereCollision> spheres;
+        std::vector<CapsuleCollision> capsules;
+        std::vector<AABBCollision> boxes;
+        std::vector<CubeCollision> cubes;
+        //spheres, capsules の順の BodyHandle
+        std::vector<BodyHandle> bodies;
+        //spheres -> capsules -> boxes -> cubes の順に並べた AABB と その BVH
+        std::vector<AABBCollision> bounds;
+        StaticBVH bvh;
+
+        std::vector<Segment> rays;
+    };
+}// namespace myTools
+
+#endif /* RayCastBatch_h */
@@ -0,0 +1,706 @@
+//
+//  World.cpp
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/31.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#include "World.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cmath>
+
+namespace myTools {
+
+    namespace {
+        //1ジョブで回す数
+        const int bodyGrain = 256;
+        const int pairGrain = 128;
+        const int mapGrain = 32;
+    }
+
+    World::World(int threadCount) : jobs(threadCount){
+        mapCandidates.resize(jobs.GetThreadCount());
+    }
+
+    int World::AddSphere(const MoveCollData<SphereCollision>& data){
+        int index = (int)sphereDatas.size();
+        sphereDatas.push_back(data);
+        MoveCollData<SphereCollision>& sphere = sphereDatas.back();
+        sphere.body = bodies.Create(sphere.phys);
+        //移動後の位置が 0 のままだと原点までの大きな AABB になるので, 作った状態を写してから求める
+        bodies.Load(sphere.body, sphere.phys);
+        CulcAABB(sphere);
+        sphereProxies.push_back(CreateProxy(sphere.aabb));
+        AddBodyRef(BodyType::Sphere, index, sphere.body);
+        return index;
+    }
+
+    int World::AddCapsule(const MoveCollData<CapsuleCollision>& data){
+        int index = (int)capDatas.size();
+        capDatas.push_back(data);
+        MoveCollData<CapsuleCollision>& capsule = capDatas.back();
+        capsule.body = bodies.Create(capsule.phys);
+        bodies.Load(capsule.body, capsule.phys);
+        CulcAABB(capsule);
+        capProxies.push_back(CreateProxy(capsule.aabb));
+        AddBodyRef(BodyType::Capsule, index, capsule.body);
+        return index;
+    }
+
+    void World::AddBodyRef(BodyType type, int index, BodyHandle handle){
+        int ref = (int)bodyRefs.size();
+        bodyRefs.push_back({type, index});
+        isSleeping.push_back(0);
+        sleepTimers.push_back(0.0f);
+        islands.push_back(ref);
+        if(handle.index >= slotToRef.size()){
+            slotToRef.resize(handle.index + 1, -1);
+        }
+        slotToRef[handle.index] = ref;
+    }
+
+    void World::GetBoundingSphere(int ref, Vector3& center, float& radius) const {
+        const BodyRef& body = bodyRefs[ref];
+        if(body.type == BodyType::Sphere){
+            const MoveCollData<SphereCollision>& sphere = sphereDatas[body.index];
+            center = sphere.phys.GetPosition();
+            radius = sphere.collision.radius;
+        }
+        else {
+            const MoveCollData<CapsuleCollision>& cap = capDatas[body.index];
+            Vector3 halfVec = cap.collision.s.v * 0.5f;
+            center = cap.phys.GetPosition() + halfVec;
+            radius = halfVec.Length() + cap.collision.radius;
+        }
+    }
+
+    void World::AddStaticBox(const AABBCollision& box){
+        staticBoxes.push_back(box);
+        isStaticDirty = true;
+    }
+
+    void World::AddStaticCube(const CubeCollision& cube){
+        staticCubes.push_back(cube);
+        staticCubeBounds.push_back(CastToAABB(cube));
+        isStaticDirty = true;
+    }
+
+    int World::CreateProxy(const AABBCollision& aabb){
+        if(broadPhaseMode == BroadPhaseMode::SpatialHash){
+            //ハッシュグリッドはproxyを持たないのでbodyRefsの添字をそのまま使う
+            return (int)bodyRefs.size();
+        }
+        if(broadPhaseMode == BroadPhaseMode::SweepAndPrune){
+            return sweepAndPrune.AddProxy(aabb, (int)bodyRefs.size());
+        }
+        return broadPhase.CreateProxy(aabb, (int)bodyRefs.size());
+    }
+
+    void World::MoveProxy(int proxyId, const AABBCollision& aabb){
+        if(broadPhaseMode == BroadPhaseMode::SweepAndPrune){
+            sweepAndPrune.UpdateProxy(proxyId, aabb);
+        }
+        else if(broadPhaseMode == BroadPhaseMode::AABBTree){
+            broadPhase.MoveProxy(proxyId, aabb);
+        }
+    }
+
+    int World::Advance(float elapsed){
+        if(elapsed > 0.0f){
+            accumulator += elapsed;
+        }
+        int stepCount = (int)(accumulator / fixedDelta);
+        if(stepCount > maxSubSteps){
+            //追いつけない分は捨てる. 端数だけ残して補間に使う
+            accumulator = fmodf(accumulator, fixedDelta);
+            stepCount = maxSubSteps;
+        }
+        else {
+            accumulator -= stepCount * fixedDelta;
+        }
+        for(int i = 0; i < stepCount; ++i){
+            //補間に使うのは最後の2つの状態だけ
+            if(i == stepCount - 1){
+                prePositions = bodies.GetPositions();
+            }
+            Step(fixedDelta);
+        }
+        return stepCount;
+    }
+
+    Vector3 World::GetRenderPosition(BodyHandle handle) const {
+        int index = bodies.GetIndex(handle);
+        const Vector3& position = bodies.GetPositions()[index];
+        if(index >= prePositions.size()){
+            return position;
+        }
+        float alpha = GetAlpha();
+        return prePositions[index] * (1.0f - alpha) + position * alpha;
+    }
+
+    void World::Step(float delta){
+        PROFILE_ZONE("Step");
+        //地形は動かないので変わったときだけ組み立てる
+        if(isStaticDirty){
+            PROFILE_ZONE("BuildStaticBVH");
+            staticBVH.Build(staticBoxes);
+            staticCubeBVH.Build(staticCubeBounds);
+            isStaticDirty = false;
+        }
+
+        WakeMovedIslands();
+        Integrate(delta);
+        const std::vector<std::pair<int,int>>& pairs = UpdateBroadPhase();
+        if(contactSolverMode == ContactSolverMode::OneShot){
+            CulcContactFixes(delta, pairs);
+            WakeTouchedIslands(pairs);
+        }
+        else {
+            CulcContacts(pairs);
+            //起こした物体も一緒に解く
+            WakeTouchedIslands(pairs);
+            SolveContacts(delta);
+            //pairManifolds は解き終わるまで使うので, 古い接触を捨てるのはここ
+            contactCache.EndStep();
+        }
+        PreFix();
+        CulcMapFixes(delta);
+        Fix();
+        UpdateSleep(delta, pairs);
+    }
+
+    void World::Integrate(float delta){
+        PROFILE_ZONE("Integrate");
+        bodies.AddAcceleration(gravity);
+        bodies.Update(delta, true, jobs);
+        //判定用にPhysicsへ写す
+        //眠っている物体は眠った時に写してあるのでそのまま
+        jobs.ParallelFor(0, (int)sphereDatas.size(), bodyGrain, [&](int first, int last){
+            for(int i = first; i < last; ++i){
+                if(bodies.IsSleeping(sphereDatas[i].body)){
+                    continue;
+                }
+                bodies.Load(sphereDatas[i].body, sphereDatas[i].phys);
+                CulcAABB(sphereDatas[i]);
+            }
+        });
+        jobs.ParallelFor(0, (int)capDatas.size(), bodyGrain, [&](int first, int last){
+            for(int i = first; i < last; ++i){
+                if(bodies.IsSleeping(capDatas[i].body)){
+                    continue;
+                }
+                bodies.Load(capDatas[i].body, capDatas[i].phys);
+                CulcAABB(capDatas[i]);
+            }
+        });
+    }
+
+    void World::PreFix(){
+        PROFILE_ZONE("PreFix");
+        //物体ごとにペアの番号順で足すのでスレッド数によらず同じ結果になる
+        jobs.ParallelFor(0, (int)bodyRefs.size(), bodyGrain, [&](int first, int last){
+            for(int i = first; i < last; ++i){
+                if(isSleeping[i]){
+                    continue;
+                }
+                Physics& phys = GetPhysics(i);
+                contactFixes.Apply(i, phys);
+                phys.PreFix();
+            }
+        });
+    }
+
+    void World::Fix(){
+        PROFILE_ZONE("Fix");
+        jobs.ParallelFor(0, (int)sphereDatas.size(), bodyGrain, [&](int first, int last){
+            for(int i = first; i < last; ++i){
+                if(bodies.IsSleeping(sphereDatas[i].body)){
+                    continue;
+                }
+                bodies.Save(sphereDatas[i].body, sphereDatas[i].phys);
+                sphereDatas[i].phys.ResetFix();
+            }
+        });
+        jobs.ParallelFor(0, (int)capDatas.size(), bodyGrain, [&](int first, int last){
+            for(int i = first; i < last; ++i){
+                if(bodies.IsSleeping(capDatas[i].body)){
+                    continue;
+                }
+                bodies.Save(capDatas[i].body, capDatas[i].phys);
+                capDatas[i].phys.ResetFix();
+            }
+        });
+        bodies.Fix(jobs);
+
+        //次のフレームの判定のために当たり判定の位置を合わせる
+        for(auto& data : sphereDatas){
+            data.collision.position = bodies.Position(data.body);
+        }
+        for(auto& data : capDatas){
+            data.collision.s.p = bodies.Position(data.body);
+        }
+    }
+
+    const std::vector<std::pair<int,int>>& World::UpdateBroadPhase(){
+        PROFILE_ZONE("BroadPhase");
+        //木の更新は1スレッドで行う
+        //眠っている物体は動かないので木を直さなくてよい
+        for(int i = 0; i < sphereDatas.size(); ++i){
+            if(!bodies.IsSleeping(sphereDatas[i].body)){
+                MoveProxy(sphereProxies[i], sphereDatas[i].aabb);
+            }
+        }
+        for(int i = 0; i < capDatas.size(); ++i){
+            if(!bodies.IsSleeping(capDatas[i].body)){
+                MoveProxy(capProxies[i], capDatas[i].aabb);
+            }
+        }
+
+        if(broadPhaseMode == BroadPhaseMode::SweepAndPrune){
+            //ペアはフレームをまたいで保持されている
+            sweepAndPrune.Update();
+            return sweepAndPrune.GetPairs();
+        }
+        if(broadPhaseMode == BroadPhaseMode::SpatialHash){
+            //毎フレーム作り直す
+            spatialHash.Clear();
+            for(int i = 0; i < sphereDatas.size(); ++i){
+                spatialHash.Insert(sphereDatas[i], sphereProxies[i]);
+            }
+            for(int i = 0; i < capDatas.size(); ++i){
+                spatialHash.Insert(capDatas[i], capProxies[i]);
+            }
+            spatialHash.QueryPairs(hitPairs);
+        }
+        else if(isSleepEnabled){
+            //眠っている物体同士のペアは探さない
+            broadPhase.QueryPairs(hitPairs, [&](int ref){
+                return !isSleeping[ref];
+            });
+        }
+        else {
+            broadPhase.QueryPairs(hitPairs);
+        }
+        return hitPairs;
+    }
+
+    void World::CulcContactFixes(float delta, const std::vector<std::pair<int,int>>& pairs){
+        PROFILE_ZONE("CulcFix");
+        //CulcFix は移動後の位置を変えないので判定だけ先に(並列に)済ませても結果は同じ
+        sphereBatch.Clear();
+        pairBatchIndex.resize(pairs.size());
+        for(int i = 0; i < pairs.size(); ++i){
+            const BodyRef& lhs = bodyRefs[pairs[i].first];
+            const BodyRef& rhs = bodyRefs[pairs[i].second];
+            pairBatchIndex[i] = -1;
+            if(isSleeping[pairs[i].first] && isSleeping[pairs[i].second]){
+                continue;
+            }
+            if(lhs.type == BodyType::Sphere && rhs.type == BodyType::Sphere){
+                pairBatchIndex[i] = sphereBatch.GetCount();
+                sphereBatch.Add(sphereDatas[lhs.index], sphereDatas[rhs.index]);
+            }
+        }
+        sphereBatch.Culc(sphereHits, jobs);
+
+        //修正量はペアごとの記録に書くだけなのでペア単位で並列に回せる
+        contactFixes.Reset((int)bodyRefs.size(), (int)pairs.size());
+        pairTouched.resize(pairs.size());
+        jobs.ParallelFor(0, (int)pairs.size(), pairGrain, [&](int first, int last){
+            PROFILE_ZONE("CulcFix Range");
+            for(int i = first; i < last; ++i){
+                int lhsRef = pairs[i].first;
+                int rhsRef = pairs[i].second;
+                const BodyRef& lhs = bodyRefs[lhsRef];
+                const BodyRef& rhs = bodyRefs[rhsRef];
+                ContactFix& fix = contactFixes.GetFix(i);
+                //眠っている物体同士は判定しない
+                if(isSleeping[lhsRef] && isSleeping[rhsRef]){
+                    fix = ContactFix();
+                    contactFixes.SetBodies(i, lhsRef, rhsRef);
+                    continue;
+                }
+                if(lhs.type == BodyType::Sphere){
+                    auto& sphere = sphereDatas[lhs.index];
+                    if(rhs.type == BodyType::Sphere){
+                        CulcFix(delta, sphere, sphereDatas[rhs.index], sphereHits[pairBatchIndex[i]], fix);
+                    }
+                    else {
+                        auto& cap = capDatas[rhs.index];
+                        CulcFix(delta, sphere, cap, MoveCollision(sphere, cap), fix);
+                    }
+                    contactFixes.SetBodies(i, lhsRef, rhsRef);
+                }
+                else {
+                    auto& cap = capDatas[lhs.index];
+                    if(rhs.type == BodyType::Sphere){
+                        auto& sphere = sphereDatas[rhs.index];
+                        CulcFix(delta, sphere, cap, MoveCollision(sphere, cap), fix);
+                        contactFixes.SetBodies(i, rhsRef, lhsRef);
+                    }
+                    else {
+                        auto& cap2 = capDatas[rhs.index];
+                        CulcFix(delta, cap, cap2, MoveCollision(cap, cap2), fix);
+                        contactFixes.SetBodies(i, lhsRef, rhsRef);
+                    }
+                }
+                pairTouched[i] = fix.hit ? 1 : 0;
+            }
+        });
+        contactFixes.BuildBodyLists();
+    }
+
+    void World::CulcContacts(const std::vector<std::pair<int,int>>& pairs){
+        PROFILE_ZONE("CulcContact");
+        //修正量は使わないので空にしておく
+        contactFixes.Reset((int)bodyRefs.size(), 0);
+        contactFixes.BuildBodyLists();
+
+        //ペアの向きを揃え, 包む球同士が届かないペアは外す
+        //同じ種類なら番号の小さい方, 球とカプセルなら球を lhs にする
+        float slop = contactSolver.GetSlop();
+        contactPairs.resize(pairs.size());
+        pairTouched.resize(pairs.size());
+        jobs.ParallelFor(0, (int)pairs.size(), pairGrain, [&](int first, int last){
+            for(int i = first; i < last; ++i){
+                int lhsRef = pairs[i].first;
+                int rhsRef = pairs[i].second;
+                pairTouched[i] = 0;
+                contactPairs[i] = std::make_pair(-1, -1);
+                if(isSleeping[lhsRef] && isSleeping[rhsRef]){
+                    continue;
+                }
+                BodyType lhsType = bodyRefs[lhsRef].type;
+                BodyType rhsType = bodyRefs[rhsRef].type;
+                if(lhsType == rhsType ? rhsRef < lhsRef : lhsType == BodyType::Capsule){
+                    std::swap(lhsRef, rhsRef);
+                }
+                Vector3 lhsCenter, rhsCenter;
+                float lhsRadius, rhsRadius;
+                GetBoundingSphere(lhsRef, lhsCenter, lhsRadius);
+                GetBoundingSphere(rhsRef, rhsCenter, rhsRadius);
+                //このステップで近づける距離より離れていれば当たらない
+                float margin = (CulcVel(GetPhysics(lhsRef)) - CulcVel(GetPhysics(rhsRef))).Length() + slop;
+                float reach = lhsRadius + rhsRadius + margin;
+                if((rhsCenter - lhsCenter).LengthSq() < reach * reach){
+                    contactPairs[i] = std::make_pair(lhsRef, rhsRef);
+                }
+            }
+        });
+
+        //届くペアだけ接触点を探す(1スレッドで)
+        contactCache.BeginStep();
+        pairManifolds.resize(pairs.size());
+        for(int i = 0; i < pairs.size(); ++i){
+            int lhsRef = contactPairs[i].first;
+            int rhsRef = contactPairs[i].second;
+            if(lhsRef < 0){
+                pairManifolds[i] = nullptr;
+                continue;
+            }
+            ContactManifold& manifold = contactCache.Get(GetHandle(lhsRef), GetHandle(rhsRef));
+            manifold.lhs = lhsRef;
+            manifold.rhs = rhsRef;
+            pairManifolds[i] = &manifold;
+        }
+
+        jobs.ParallelFor(0, (int)pairs.size(), pairGrain, [&](int first, int last){
+            for(int i = first; i < last; ++i){
+                if(!pairManifolds[i]){
+                    continue;
+                }
+                ContactManifold& manifold = *pairManifolds[i];
+                int lhsRef = manifold.lhs;
+                int rhsRef = manifold.rhs;
+                const Physics& lhsPhys = GetPhysics(lhsRef);
+                const Physics& rhsPhys = GetPhysics(rhsRef);
+                //ほとんど動いていなければ前の接触点をずらして使う
+                if(contactCache.CanReuse(manifold, lhsPhys.GetPosition(), rhsPhys.GetPosition())){
+                    contactCache.Reuse(manifold, lhsPhys.GetPosition(), rhsPhys.GetPosition());
+                }
+                else {
+                    const BodyRef& lhs = bodyRefs[lhsRef];
+                    const BodyRef& rhs = bodyRefs[rhsRef];
+                    ContactManifold fresh;
+                    if(lhs.type == BodyType::Sphere && rhs.type == BodyType::Sphere){
+                        CulcManifold(sphereDatas[lhs.index], sphereDatas[rhs.index], fresh);
+                    }
+                    else if(lhs.type == BodyType::Sphere){
+                        CulcManifold(sphereDatas[lhs.index], capDatas[rhs.index], fresh);
+                    }
+                    else {
+                        CulcManifold(capDatas[lhs.index], capDatas[rhs.index], fresh);
+                    }
+                    contactCache.Update(manifold, fresh);
+                }
+                float margin = (CulcVel(lhsPhys) - CulcVel(rhsPhys)).Length() + slop;
+                manifold.hit = manifold.GetMinSeparation() < margin;
+                pairTouched[i] = manifold.hit ? 1 : 0;
+            }
+        });
+    }
+
+    void World::SolveContacts(float delta){
+        PROFILE_ZONE("Solve");
+        int refCount = (int)bodyRefs.size();
+        contactSolver.Begin(refCount);
+        for(int i = 0; i < refCount; ++i){
+            //眠っている物体は動かない壁として扱う
+            if(!isSleeping[i]){
+                const Physics& phys = GetPhysics(i);
+                contactSolver.SetBody(i, phys.GetPreVel(), phys.GetMassRate());
+            }
+        }
+        for(const ContactManifold* manifold : pairManifolds){
+            if(!manifold || !manifold->hit){
+                continue;
+            }
+            for(int i = 0; i < manifold->pointCount; ++i){
+                const ContactPoint& point = manifold->points[i];
+                Contact contact;
+                contact.lhs = manifold->lhs;
+                contact.rhs = manifold->rhs;
+                contact.normal = point.normal;
+                contact.separation = point.separation;
+                contact.impulse = point.impulse;
+                contactSolver.AddContact(contact);
+            }
+        }
+        contactSolver.Solve(delta);
+
+        //速度の変化分だけ移動後の位置もずらす
+        jobs.ParallelFor(0, refCount, bodyGrain, [&](int first, int last){
+            for(int i = first; i < last; ++i){
+                if(isSleeping[i]){
+                    continue;
+                }
+                Physics& phys = GetPhysics(i);
+                Vector3 difVel = contactSolver.GetVelocity(i) - phys.GetPreVel();
+                phys.SetPreVel(contactSolver.GetVelocity(i));
+                phys.SetPrePos(phys.GetPrePos() + difVel * delta);
+            }
+        });
+
+        //力積は次のステップのために残す
+        //島は触れているか押し合った接触で作る
+        float slop = contactSolver.GetSlop();
+        int contactIndex = 0;
+        for(int i = 0; i < pairManifolds.size(); ++i){
+            if(!pairManifolds[i]){
+                continue;
+            }
+            ContactManifold& manifold = *pairManifolds[i];
+            if(!manifold.hit){
+                for(int j = 0; j < manifold.pointCount; ++j){
+                    manifold.points[j].impulse = 0.0f;
+                }
+                continue;
+            }
+            bool isTouched = false;
+            for(int j = 0; j < manifold.pointCount; ++j, ++contactIndex){
+                ContactPoint& point = manifold.points[j];
+                point.impulse = contactSolver.GetImpulse(contactIndex);
+                isTouched = isTouched || contactSolver.IsPushed(contactIndex) || point.separation <= slop;
+            }
+            pairTouched[i] = isTouched ? 1 : 0;
+        }
+    }
+
+    //移動範囲と重なる箱だけを追加した順番で判定する
+    template<typename Ty, typename StaticTy>
+    void World::CulcBodyMapFix(float delta, MoveCollData<Ty>& data, const StaticBVH& bvh,
+                               const std::vector<StaticTy>& statics, std::vector<int>& candidates){
+        CulcAABB(data);
+        bvh.Query(data.aabb, candidates);
+        for(int i = 0; i < candidates.size(); ++i){
+            int index = candidates[i];
+            Vector3 prePos = data.phys.GetPrePos();
+            CulcMapFix(delta, data, statics[index]);
+            Vector3 fixedPos = data.phys.GetPrePos();
+            if(prePos.x == fixedPos.x && prePos.y == fixedPos.y && prePos.z == fixedPos.z){
+                continue;
+            }
+            //押し戻されたら移動範囲が変わるので取り直して続きから判定する
+            CulcAABB(data);
+            bvh.Query(data.aabb, candidates);
+            i = (int)(std::upper_bound(candidates.begin(), candidates.end(), index) - candidates.begin()) - 1;
+        }
+    }
+
+    void World::CulcMapFixes(float delta){
+        PROFILE_ZONE("CulcMapFix");
+        if(staticBoxes.empty() && staticCubes.empty()){
+            return;
+        }
+        //物体ごとに独立なので並列に回す
+        jobs.ParallelFor(0, (int)sphereDatas.size(), mapGrain, [&](int first, int last){
+            PROFILE_ZONE("CulcMapFix Range");
+            std::vector<int>& candidates = mapCandidates[jobs.GetThreadIndex()];
+            for(int i = first; i < last; ++i){
+                if(bodies.IsSleeping(sphereDatas[i].body)){
+                    continue;
+                }
+                CulcBodyMapFix(delta, sphereDatas[i], staticBVH, staticBoxes, candidates);
+                CulcBodyMapFix(delta, sphereDatas[i], staticCubeBVH, staticCubes, candidates);
+            }
+        });
+        jobs.ParallelFor(0, (int)capDatas.size(), mapGrain, [&](int first, int last){
+            PROFILE_ZONE("CulcMapFix Range");
+            std::vector<int>& candidates = mapCandidates[jobs.GetThreadIndex()];
+            for(int i = first; i < last; ++i){
+                if(bodies.IsSleeping(capDatas[i].body)){
+                    continue;
+                }
+                CulcBodyMapFix(delta, capDatas[i], staticBVH, staticBoxes, candidates);
+                CulcBodyMapFix(delta, capDatas[i], staticCubeBVH, staticCubes, candidates);
+            }
+        });
+    }
+
+    void World::SetSleepEnabled(bool isEnabled){
+        isSleepEnabled = isEnabled;
+        if(!isEnabled){
+            //全部起こす
+            isWakeIsland.assign(bodyRefs.size(), 1);
+            WakeIslands(isWakeIsland);
+        }
+    }
+
+    void World::WakeUp(BodyHandle handle){
+        int ref = slotToRef[handle.index];
+        if(!isSleeping[ref]){
+            return;
+        }
+        isWakeIsland.assign(bodyRefs.size(), 0);
+        isWakeIsland[islands[ref]] = 1;
+        WakeIslands(isWakeIsland);
+    }
+
+    int World::FindIsland(int ref){
+        //経路を半分に縮めながら辿る
+        while(islandParents[ref] != ref){
+            islandParents[ref] = islandParents[islandParents[ref]];
+            ref = islandParents[ref];
+        }
+        return ref;
+    }
+
+    void World::WakeIslands(const std::vector<char>& isWakeIsland){
+        for(int i = 0; i < bodyRefs.size(); ++i){
+            if(isSleeping[i] && isWakeIsland[islands[i]]){
+                isSleeping[i] = 0;
+                sleepTimers[i] = 0.0f;
+                bodies.SetSleeping(GetHandle(i), false);
+            }
+        }
+    }
+
+    void World::WakeMovedIslands(){
+        //外から力や速度を与えられた物体の島を起こす(重力は眠っている物体には足さない)
+        bool isWake = false;
+        isWakeIsland.assign(bodyRefs.size(), 0);
+        for(int i = 0; i < bodyRefs.size(); ++i){
+            if(!isSleeping[i]){
+                continue;
+            }
+            BodyHandle handle = GetHandle(i);
+            if(!(bodies.Acceleration(handle) == 0.0f) || !(bodies.Velocity(handle) == 0.0f)){
+                isWakeIsland[islands[i]] = 1;
+                isWake = true;
+            }
+        }
+        if(isWake){
+            WakeIslands(isWakeIsland);
+        }
+    }
+
+    void World::WakeTouchedIslands(const std::vector<std::pair<int,int>>& pairs){
+        //起きている物体が当たった眠っている島を起こす. 修正量はこのフレームから足す
+        bool isWake = false;
+        isWakeIsland.assign(bodyRefs.size(), 0);
+        for(int i = 0; i < pairs.size(); ++i){
+            int lhs = pairs[i].first;
+            int rhs = pairs[i].second;
+            if(isSleeping[lhs] == isSleeping[rhs] || !pairTouched[i]){
+                continue;
+            }
+            int sleeper = isSleeping[lhs] ? lhs : rhs;
+            isWakeIsland[islands[sleeper]] = 1;
+            isWake = true;
+        }
+        if(isWake){
+            WakeIslands(isWakeIsland);
+        }
+    }
+
+    void World::UpdateSleep(float delta, const std::vector<std::pair<int,int>>& pairs){
+        PROFILE_ZONE("Island");
+        if(!isSleepEnabled){
+            return;
+        }
+        int refCount = (int)bodyRefs.size();
+        //当たった物体同士を同じ島にする. 動かない箱とは繋げない(箱を介して全部が1つの島になるため)
+        islandParents.resize(refCount);
+        for(int i = 0; i < refCount; ++i){
+            islandParents[i] = i;
+        }
+        for(int i = 0; i < pairs.size(); ++i){
+            int lhs = pairs[i].first;
+            int rhs = pairs[i].second;
+            if(!pairTouched[i] || isSleeping[lhs] || isSleeping[rhs]){
+                continue;
+            }
+            int lhsRoot = FindIsland(lhs);
+            int rhsRoot = FindIsland(rhs);
+            if(lhsRoot != rhsRoot){
+                //小さい番号を根にしておけば島の番号がスレッド数によらず決まる
+                islandParents[std::max(lhsRoot, rhsRoot)] = std::min(lhsRoot, rhsRoot);
+            }
+        }
+
+        //島の中で一番短いタイマーが島のタイマー
+        islandTimers.assign(refCount, sleepTime);
+        float sleepVelocitySq = sleepVelocity * sleepVelocity;
+        for(int i = 0; i < refCount; ++i){
+            if(isSleeping[i]){
+                continue;
+            }
+            if(bodies.Velocity(GetHandle(i)).LengthSq() < sleepVelocitySq){
+                sleepTimers[i] += delta;
+            }
+            else {
+                sleepTimers[i] = 0.0f;
+            }
+            int root = FindIsland(i);
+            islands[i] = root;
+            islandTimers[root] = std::min(islandTimers[root], sleepTimers[i]);
+        }
+        for(int i = 0; i < refCount; ++i){
+            if(!isSleeping[i] && islandTimers[islands[i]] >= sleepTime){
+                Sleep(i);
+            }
+        }
+    }
+
+    void World::Sleep(int ref){
+        isSleeping[ref] = 1;
+        BodyHandle handle = GetHandle(ref);
+        bodies.SetSleeping(handle, true);
+        //止めた状態を判定用に写して, 起きるまでこのまま使う
+        const BodyRef& body = bodyRefs[ref];
+        if(body.type == BodyType::Sphere){
+            MoveCollData<SphereCollision>& data = sphereDatas[body.index];
+            bodies.Load(handle, data.phys);
+            CulcAABB(data);
+            MoveProxy(sphereProxies[body.index], data.aabb);
+        }
+        else {
+            MoveCollData<CapsuleCollision>& data = capDatas[body.index];
+            bodies.Load(handle, data.phys);
+            CulcAABB(data);
+            MoveProxy(capProxies[body.index], data.aabb);
+        }
+    }
+}// namespace myTools
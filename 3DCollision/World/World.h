@@ -0,0 +1,308 @@
+//
+//  World.h
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/01/31.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+#ifndef World_h
+#define World_h
+
+#include "Physics.h"
+#include "BodyStore.h"
+#include "AABBTree.h"
+#include "SweepAndPrune.h"
+#include "SpatialHash.h"
+#include "StaticBVH.h"
+#include "SphereBatch.h"
+#include "ContactFixBuffer.h"
+#include "ContactSolver.h"
+#include "ContactCache.h"
+#include "JobSystem.h"
+#include <vector>
+#include <utility>
+
+namespace myTools {
+
+    /**
+     *  @tips   Runs the simulation without drawing.
+     *          Holds spheres and capsules (moving bodies) and static boxes. Step advances one frame.
+     *          It does not depend on GL, so it also runs headless (e.g. on a server)
+     */
+    class World {
+    public:
+        enum class BroadPhaseMode {
+            AABBTree,
+            SweepAndPrune,
+            SpatialHash,
+        };
+        enum class ContactSolverMode {
+            //CulcFix で衝突時刻から1回で修正する(以前の方法)
+            OneShot,
+            //ContactSolver で反復して解く
+            SequentialImpulse,
+        };
+
+        /**
+         *  @tips   threadCount is passed to JobSystem (0 uses every hardware thread)
+         */
+        explicit World(int threadCount = 0);
+
+        /**
+         *  @tips   Change the broad phase. Call before adding any body.
+         */
+        void SetBroadPhaseMode(BroadPhaseMode mode){
+            broadPhaseMode = mode;
+        }
+        BroadPhaseMode GetBroadPhaseMode() const {
+            return broadPhaseMode;
+        }
+        //SpatialHash のセルの大きさ. 物体の直径くらいにしておく
+        void SetSpatialHashCellSize(float cellSize){
+            spatialHash.SetCellSize(cellSize);
+        }
+
+        void SetContactSolverMode(ContactSolverMode mode){
+            contactSolverMode = mode;
+            contactCache.Clear();
+        }
+        ContactSolverMode GetContactSolverMode() const {
+            return contactSolverMode;
+        }
+        //反復回数などの設定はここから
+        ContactSolver& GetContactSolver(){
+            return contactSolver;
+        }
+        //接触点を使い回す閾値などの設定はここから
+        ContactCache& GetContactCache(){
+            return contactCache;
+        }
+
+        void SetGravity(const Vector3& gravity){
+            this->gravity = gravity;
+        }
+        Vector3 GetGravity() const {
+            return gravity;
+        }
+
+        /**
+         *  @tips   Islands whose every body stays slower than sleepVelocity for sleepTime
+         *          go to sleep and are skipped by integration, the broad phase update and
+         *          the narrow phase. They wake when an awake body hits them or when
+         *          a force or velocity is given to one of their bodies.
+         */
+        void SetSleepEnabled(bool isEnabled);
+        bool IsSleepEnabled() const {
+            return isSleepEnabled;
+        }
+        void SetSleepVelocity(float velocity){
+            sleepVelocity = velocity;
+        }
+        void SetSleepTime(float time){
+            sleepTime = time;
+        }
+        bool IsSleeping(BodyHandle handle) const {
+            return bodies.IsSleeping(handle);
+        }
+        //handle の物体がいる島ごと起こす
+        void WakeUp(BodyHandle handle);
+
+        /**
+         *  @tips   Add a body. Returns the index in GetSpheres() / GetCapsules().
+         *          data.phys gives the first position, velocity, acceleration and mass.
+         */
+        int AddSphere(const MoveCollData<SphereCollision>& data);
+        int AddCapsule(const MoveCollData<CapsuleCollision>& data);
+
+        /**
+         *  @tips   Add a box that never moves. Boxes are checked in the order they were added.
+         */
+        void AddStaticBox(const AABBCollision& box);
+        /**
+         *  @tips   Add a rotated box (OBB) that never moves. Checked after all the boxes,
+         *          in the order they were added.
+         */
+        void AddStaticCube(const CubeCollision& cube);
+
+        /**
+         *  @tips   Advance by the wall-clock time since the last call.
+         *          Runs Step(fixedDelta) as many times as the accumulated time allows,
+         *          at most maxSubSteps times. Time beyond that is dropped so a slow frame
+         *          cannot make the next one slower (spiral of death).
+         *          Returns the number of substeps run.
+         */
+        int Advance(float elapsed);
+        //Advance で1回に進める時間. 120 ～ 240Hz くらいにしておく
+        void SetFixedDelta(float delta){
+            fixedDelta = delta > 0.0f ? delta : fixedDelta;
+        }
+        float GetFixedDelta() const {
+            return fixedDelta;
+        }
+        void SetMaxSubSteps(int count){
+            maxSubSteps = count > 0 ? count : 1;
+        }
+        int GetMaxSubSteps() const {
+            return maxSubSteps;
+        }
+        /**
+         *  @tips   How far the leftover time is into the next substep (0 to 1)
+         */
+        float GetAlpha() const {
+            return accumulator / fixedDelta;
+        }
+        /**
+         *  @tips   Position between the last two substeps of Advance for drawing.
+         *          Bodies that have not been advanced yet return their current position.
+         */
+        Vector3 GetRenderPosition(BodyHandle handle) const;
+
+        /**
+         *  @tips   Advance the simulation by delta.
+         *          integrate -> broad phase -> CulcFix or ContactSolver -> PreFix -> CulcMapFix -> Fix
+         *          Each stage is a profiler zone of the same name (Profiler.h).
+         */
+        void Step(float delta);
+
+        //collision の位置は Step の最後に合わせてある
+        std::vector<MoveCollData<SphereCollision>>& GetSpheres(){
+            return sphereDatas;
+        }
+        const std::vector<MoveCollData<SphereCollision>>& GetSpheres() const {
+            return sphereDatas;
+        }
+        std::vector<MoveCollData<CapsuleCollision>>& GetCapsules(){
+            return capDatas;
+        }
+        const std::vector<MoveCollData<CapsuleCollision>>& GetCapsules() const {
+            return capDatas;
+        }
+        const std::vector<AABBCollision>& GetStaticBoxes() const {
+            return staticBoxes;
+        }
+        const std::vector<CubeCollision>& GetStaticCubes() const {
+            return staticCubes;
+        }
+        BodyStore& GetBodies(){
+            return bodies;
+        }
+        const BodyStore& GetBodies() const {
+            return bodies;
+        }
+        JobSystem& GetJobSystem(){
+            return jobs;
+        }
+
+    private:
+        enum class BodyType {
+            Sphere,
+            Capsule,
+        };
+        struct BodyRef {
+            BodyType type;
+            int index;
+        };
+
+        BodyHandle GetHandle(int ref) const {
+            const BodyRef& body = bodyRefs[ref];
+            return body.type == BodyType::Sphere ? sphereDatas[body.index].body : capDatas[body.index].body;
+        }
+        Physics& GetPhysics(int ref){
+            const BodyRef& body = bodyRefs[ref];
+            return body.type == BodyType::Sphere ? sphereDatas[body.index].phys : capDatas[body.index].phys;
+        }
+        void AddBodyRef(BodyType type, int index, BodyHandle handle);
+        //移動前の位置で物体を包む球
+        void GetBoundingSphere(int ref, Vector3& center, float& radius) const;
+
+        int CreateProxy(const AABBCollision& aabb);
+        void MoveProxy(int proxyId, const AABBCollision& aabb);
+        void Integrate(float delta);
+        const std::vector<std::pair<int,int>>& UpdateBroadPhase();
+        void CulcContactFixes(float delta, const std::vector<std::pair<int,int>>& pairs);
+        void CulcContacts(const std::vector<std::pair<int,int>>& pairs);
+        void SolveContacts(float delta);
+        void PreFix();
+        void CulcMapFixes(float delta);
+        void Fix();
+        //島
+        int FindIsland(int ref);
+        void WakeIslands(const std::vector<char>& isWakeIsland);
+        void WakeTouchedIslands(const std::vector<std::pair<int,int>>& pairs);
+        void WakeMovedIslands();
+        void UpdateSleep(float delta, const std::vector<std::pair<int,int>>& pairs);
+        void Sleep(int ref);
+        template<typename Ty, typename StaticTy>
+        void CulcBodyMapFix(float delta, MoveCollData<Ty>& data, const StaticBVH& bvh,
+                            const std::vector<StaticTy>& statics, std::vector<int>& candidates);
+
+        JobSystem jobs;
+        BodyStore bodies;
+        //data.phys は判定用の作業領域. 本体は bodies
+        std::vector<MoveCollData<SphereCollision>> sphereDatas;
+        std::vector<MoveCollData<CapsuleCollision>> capDatas;
+        Vector3 gravity;
+
+        //固定ステップ
+        float fixedDelta = 1.0f / 120.0f;
+        int maxSubSteps = 8;
+        float accumulator = 0.0f;
+        //最後のサブステップの前の位置(添字は BodyStore::GetIndex)
+        std::vector<Vector3> prePositions;
+
+        //眠り. 添字は bodyRefs と同じ
+        bool isSleepEnabled = true;
+        //重力で1ステップに付く速度(60Hz で 0.16 程度)より大きくしておく
+        float sleepVelocity = 0.5f;
+        float sleepTime = 0.5f;
+        std::vector<char> isSleeping;
+        std::vector<float> sleepTimers;
+        //島の番号(島のどれか1つの物体の bodyRefs の添字). 眠っている物体は眠った時の島のまま
+        std::vector<int> islands;
+        //union-find の作業領域
+        std::vector<int> islandParents;
+        std::vector<float> islandTimers;
+        std::vector<char> isWakeIsland;
+        //BodyHandle::index -> bodyRefs の添字
+        std::vector<int> slotToRef;
+
+        std::vector<AABBCollision> staticBoxes;
+        StaticBVH staticBVH;
+        std::vector<CubeCollision> staticCubes;
+        //staticCubes を包む AABB(staticCubeBVH 用)
+        std::vector<AABBCollision> staticCubeBounds;
+        StaticBVH staticCubeBVH;
+        bool isStaticDirty = false;
+        //スレッドごとの作業領域
+        std::vector<std::vector<int>> mapCandidates;
+
+        BroadPhaseMode broadPhaseMode = BroadPhaseMode::AABBTree;
+        AABBTree broadPhase;
+        SweepAndPrune sweepAndPrune;
+        SpatialHash spatialHash;
+        std::vector<BodyRef> bodyRefs;
+        std::vector<int> sphereProxies;
+        std::vector<int> capProxies;
+        std::vector<std::pair<int,int>> hitPairs;
+
+        //球同士のペアは先にまとめて判定する
+        SphereTOIBatch sphereBatch;
+        std::vector<HitData> sphereHits;
+        //ペアごとの sphereHits の添字(球同士でなければ -1)
+        std::vector<int> pairBatchIndex;
+        ContactFixBuffer contactFixes;
+
+        ContactSolverMode contactSolverMode = ContactSolverMode::SequentialImpulse;
+        ContactSolver contactSolver;
+        //ペアごとの接触点(SequentialImpulse のとき). 中身は contactCache が持つ
+        ContactCache contactCache;
+        //向きを揃えたペア(届かなければ -1)と, その接触点
+        std::vector<std::pair<int,int>> contactPairs;
+        std::vector<ContactManifold*> pairManifolds;
+        //ペアが触れていたか. 島を作るのに使う
+        std::vector<char> pairTouched;
+    };
+}// namespace myTools
+
+#endif /* World_h */
@@ -13,11 +13,15 @@
 #include <math.h>
 #include <time.h>
 #include <functional>
+#include <algorithm>
 #include "Collision.h"
 #include "PrimitiveMesh.h"
 #include "Transform.h"
 #include "Physics.h"
 #include "Camera.h"
+#include "World.h"
+#include "RayCastBatch.h"
+#include "Profiler.h"
 
 #define Y_ZEORO_VECTOR3(v) Vector3(v.x,0,v.z)
 #define KEY_FLAG(key)   flags[Key::key]
@@ -143,37 +147,6 @@ struct MouseMoveCallback{
 };
 std::function<void(double,double)> MouseMoveCallback::func = nullptr;
 
-template<typename Ty>
-class Splitter {
-public:
-    void AddItem(Ty item){
-        items.push_back(item);
-    }
-    std::vector<Ty>& GetItems(){
-        return items;
-    }
-    int ItemNum(){
-        return items.size();
-    }
-    
-    Ty& operator[](int idx){
-        if(idx >= 0 && idx < items.size()){
-            return items[idx];
-        }
-        else {
-            Ty dummy;
-            return dummy;
-        }
-    }
-    
-    void Clear(){
-        items.clear();
-    }
-private:
-    std::vector<Ty> items;
-};
-
-
 template<typename Ty1, typename Ty2>
 struct HitPair{
     MoveCollData<Ty1>& lhs;
@@ -251,6 +224,8 @@ int main(int argc, const char * argv[]) {
         glfwTerminate();
         return 1;
     }
+    //球とカプセルの分割数は画面に映る大きさで選ぶ
+    drawer.SetLOD(true, windowY);
 
     
 //    Vector3 squarePos(-5.0f,0.0f,0.0f);
@@ -368,9 +343,16 @@ int main(int argc, const char * argv[]) {
     srand(sranT);
     //srand(700);
     
+    //シミュレーションは World にまとめてある. 各段階をジョブに分けて全コアで回す
+    World world;
+    world.SetBroadPhaseMode(World::BroadPhaseMode::AABBTree);
+    //描画のフレームレートに関係なく 120Hz で進める
+    world.SetFixedDelta(1.0f / 120.0f);
+    world.SetMaxSubSteps(8);
+    
     Sphere* buf;
     std::vector<Sphere*> spheres;
-    std::vector<MoveCollData<SphereCollision>> sphereDatas;
+    std::vector<MoveCollData<SphereCollision>>& sphereDatas = world.GetSpheres();
     
 //    spheres.push_back(sphere);
 //    spheres.push_back(moveObj);
@@ -380,7 +362,7 @@ int main(int argc, const char * argv[]) {
     
     MoveCollData<CapsuleCollision> capsuleData;
     std::vector<CapsuleMesh*> caps;
-    std::vector<MoveCollData<CapsuleCollision>> capDatas;
+    std::vector<MoveCollData<CapsuleCollision>>& capDatas = world.GetCapsules();
     CapsuleMesh* cBuf;
     Vector3 len(0,7,0);
     auto random = []{
@@ -395,6 +377,8 @@ int main(int argc, const char * argv[]) {
     
     static float threshold = 50.0f;
     static float size = 2.5f;
+    //セルの大きさは物体の直径くらい
+    world.SetSpatialHashCellSize(size * 2.0f);
     
     float radius;
     
@@ -414,7 +398,7 @@ int main(int argc, const char * argv[]) {
     cBuf->SetLength(len);
     cBuf->SetColor({random(),random(),random(),1.0f});
     caps.push_back(cBuf);
-    drawer.AddMesh(cBuf);
+    drawer.AddInstance(cBuf);
     sPos = Vector3(pmRandom() * threshold, pmRandom() * threshold, useZ ? pmRandom() * threshold : 0.0f);
     capsuleData.phys.SetPosition(sPos,false);
     capsuleData.phys.SetVelocity(Vector3(pmRandom(), 0.0f, useZ ? pmRandom() : 0.0f) * 15.0f);
@@ -422,7 +406,7 @@ int main(int argc, const char * argv[]) {
     capsuleData.collision.s.p = sPos;
     capsuleData.collision.s.v = len;
     capsuleData.collision.radius = radius;
-    capDatas.push_back(capsuleData);
+    world.AddCapsule(capsuleData);
 
     cBuf = new CapsuleMesh(6);
     radius = size ;//* (random() + 1);
@@ -431,7 +415,7 @@ int main(int argc, const char * argv[]) {
     cBuf->SetLength(len);
     cBuf->SetColor({random(),random(),random(),1.0f});
     caps.push_back(cBuf);
-    drawer.AddMesh(cBuf);
+    drawer.AddInstance(cBuf);
     //sPos = Vector3(pmRandom() * threshold, pmRandom() * threshold, useZ ? pmRandom() * threshold : 0.0f);
     sPos = Vector3(0.0f,0.0f,0.0f);
     capsuleData.phys.SetPosition(sPos,false);
@@ -440,7 +424,7 @@ int main(int argc, const char * argv[]) {
     capsuleData.collision.s.p = sPos;
     capsuleData.collision.s.v = len;
     capsuleData.collision.radius = radius;
-    capDatas.push_back(capsuleData);
+    world.AddCapsule(capsuleData);
     
     int num = 15;
     
@@ -464,7 +448,7 @@ int main(int argc, const char * argv[]) {
 //        capsuleData.collision.s.p = sPos;
 //        capsuleData.collision.s.v = len;
 //        capsuleData.collision.radius = radius;
-//        capDatas.push_back(capsuleData);
+//        world.AddCapsule(capsuleData);
         
         cubePointer = new Cube();
         sPos = Vector3(pmRandom() * threshold, pmRandom() * threshold, useZ ? pmRandom() * threshold : 0.0f);
@@ -479,6 +463,7 @@ int main(int argc, const char * argv[]) {
         cubeCollBuf.max = cubeWid + sPos;
         cubeCollBuf.min = -cubeWid + sPos;
         cubeCollisions.push_back(cubeCollBuf);
+        world.AddStaticBox(cubeCollBuf);
         
         float rate = 0.8f;
         buf = new Sphere(8);
@@ -488,7 +473,7 @@ int main(int argc, const char * argv[]) {
 
         //buf->SetColor({1,0,1,1});
         spheres.push_back(buf);
-        drawer.AddMesh(buf);
+        drawer.AddInstance(buf);
         sPos = Vector3(pmRandom() * threshold, pmRandom() * threshold, useZ ? pmRandom() * threshold: 0.0f) * rate;
         print(sPos);
         sphereData.phys.SetPosition(sPos,false);
@@ -496,10 +481,11 @@ int main(int argc, const char * argv[]) {
         sphereData.phys.SetMass(radius * 3);
         sphereData.collision.position = sPos;
         sphereData.collision.radius = radius;
-        sphereDatas.push_back(sphereData);
+        world.AddSphere(sphereData);
     }
     
- 
+    //剛体の状態は World がまとめて持つ. data.physは判定用の作業領域
+    BodyStore& bodies = world.GetBodies();
     
     Camera camera;
     camera.SetPosition(Vector3(0.0f,100.0f,100.0f));
@@ -599,6 +585,22 @@ int main(int argc, const char * argv[]) {
             case GLFW_KEY_ESCAPE:
                 flags[Key::ESC] = result;
                 break;
+            case GLFW_KEY_P:
+                //直前のフレームの内訳と, バッファに残っている分のトレースを書き出す
+                if(result){
+                    Profiler& profiler = Profiler::Instance();
+                    Profiler::FrameSummary summary;
+                    if(profiler.GetFrameSummary(summary)){
+                        std::cout << "frame " << summary.frame << " : " << summary.frameMs << " ms" << std::endl;
+                        for(auto& zone : summary.zones){
+                            std::cout << "  " << zone.name << " : " << zone.totalMs << " ms (" << zone.count << " max " << zone.maxMs << " ms)" << std::endl;
+                        }
+                    }
+                    if(profiler.WriteChromeTrace("trace.json")){
+                        std::cout << "wrote trace.json" << std::endl;
+                    }
+                }
+                break;
             default:
                 break;
         }
@@ -623,7 +625,7 @@ int main(int argc, const char * argv[]) {
                 cameraPos += cameraOri * speed;
             }
             else{
-                sphereDatas[1].phys.AddAcceleration(cameraOri * speed * power);
+                bodies.Acceleration(sphereDatas[1].body) += cameraOri * speed * power;
             }
         }
         if(flags[Key::S]){
@@ -631,7 +633,7 @@ int main(int argc, const char * argv[]) {
                 cameraPos -= cameraOri * speed;
             }
             else {
-                sphereDatas[1].phys.AddAcceleration(-cameraOri * speed * power);
+                bodies.Acceleration(sphereDatas[1].body) += -cameraOri * speed * power;
             }
         }
         if(flags[Key::D]){
@@ -639,7 +641,7 @@ int main(int argc, const char * argv[]) {
             cameraPos += GetRightVector(cameraOri) * speed;
             }
             else {
-                sphereDatas[1].phys.AddAcceleration(GetRightVector(cameraOri) * speed * power);
+                bodies.Acceleration(sphereDatas[1].body) += GetRightVector(cameraOri) * speed * power;
             }
         }
         if(flags[Key::A]){
@@ -647,7 +649,7 @@ int main(int argc, const char * argv[]) {
                 cameraPos -= GetRightVector(cameraOri) * speed;
             }
             else {
-                sphereDatas[1].phys.AddAcceleration(-GetRightVector(cameraOri) * speed * power);
+                bodies.Acceleration(sphereDatas[1].body) += -GetRightVector(cameraOri) * speed * power;
             }
         }
         
@@ -656,7 +658,7 @@ int main(int argc, const char * argv[]) {
                 cameraPos.y += speed;
             }
             else {
-                sphereDatas[1].phys.AddAcceleration(Vector3(0,1,0) * speed * power);
+                bodies.Acceleration(sphereDatas[1].body) += Vector3(0,1,0) * speed * power;
             }
 
 //            if(!jumpRest){
@@ -672,7 +674,7 @@ int main(int argc, const char * argv[]) {
             cameraPos.y -= speed;
             }
             else {
-                sphereDatas[1].phys.AddAcceleration(Vector3(0,-1,0) * speed * power);
+                bodies.Acceleration(sphereDatas[1].body) += Vector3(0,-1,0) * speed * power;
             }
         }
         camera.SetPosition(cameraPos);
@@ -775,15 +777,15 @@ int main(int argc, const char * argv[]) {
         }
         if(KEY_FLAG(L)){
             //dome.position += Vector3(1,0,0) * speed;
-            capDatas[1].phys.AddAcceleration(Vector3(1,0,0) * speed * power);
+            bodies.Acceleration(capDatas[1].body) += Vector3(1,0,0) * speed * power;
         }
         if(KEY_FLAG(U)){
             //dome.position += Vector3(0,-1,0) * speed;
-            capDatas[1].phys.AddAcceleration(Vector3(0,-1,0) * speed * power);
+            bodies.Acceleration(capDatas[1].body) += Vector3(0,-1,0) * speed * power;
         }
         if(KEY_FLAG(O)){
             //dome.position += Vector3(0,1,0) * speed;
-            capDatas[1].phys.AddAcceleration(Vector3(0,1,0) * speed * power * jumpPower);
+            bodies.Acceleration(capDatas[1].body) += Vector3(0,1,0) * speed * power * jumpPower;
         }
     };
     
@@ -854,13 +856,14 @@ int main(int argc, const char * argv[]) {
         end = cameraMat * end;
         coll.p = {start.x, start.y, start.z};
         coll.v = toVec3(end - start) * 1000 ;
-        for(int i = 0; i < spheres.size(); ++i){
-            if(CollisionReturnFlag(sphereDatas[i].collision, coll)){
-                spheres[i]->SetColor(hitColor);
-            }
-            else {
-                //spheres[i]->SetColor(defaultColor);
-            }
+        //壁に隠れていない一番手前の球に当てる
+        RayCastBatch rayBatch;
+        rayBatch.Build(world);
+        rayBatch.Add(coll);
+        std::vector<RayHit> hits;
+        rayBatch.Cast(hits);
+        if(hits[0].type == RayHit::Type::Sphere){
+            spheres[hits[0].index]->SetColor(hitColor);
         }
         
 //        auto ray = new LineMesh(toVec3(start),toVec3(end - start) * 10 + toVec3(start));
@@ -955,8 +958,6 @@ int main(int argc, const char * argv[]) {
         return 1;
     }
     
-    std::vector<Splitter< MoveCollData<SphereCollision>* >> splitter(9);
-    
     std::vector<HitPair<SphereCollision, SphereCollision>> spherePairs;
 
     Cube* cubes[6];
@@ -1025,6 +1026,11 @@ int main(int argc, const char * argv[]) {
 //    drawer.AddMesh(cubes[6]);
 
     
+    //箱の後に壁を判定する
+    for(auto& wall : walls){
+        world.AddStaticBox(wall);
+    }
+    
     while (!glfwWindowShouldClose(window) && !endFlag) {
         glClearColor(0.0f, 0.0f, 0.1f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -1033,23 +1039,18 @@ int main(int argc, const char * argv[]) {
         
         cameraFunc();
         
-        float delta = 1.0f / 60.0f;
+        //前のフレームからの実時間
+        static double preTime = glfwGetTime();
+        double nowTime = glfwGetTime();
+        float elapsed = (float)(nowTime - preTime);
+        preTime = nowTime;
         
         Vector3 gravity(0.0f,-9.8f * 15.0f,0.0f);
         gravity = Vector3();
         
+        world.SetGravity(gravity);
         if(!skip){
-        
-        for(auto& data : sphereDatas){
-            data.phys.AddAcceleration(gravity);
-            data.phys.Update(delta, true);
-        }
-        
-        for(auto& data : capDatas){
-            data.phys.AddAcceleration(gravity);
-            data.phys.Update(delta, true);
-        }
-        
+            world.Advance(elapsed);
         }
 //        static int counter = 0;
 //        static int interval = 10;
@@ -1099,114 +1100,6 @@ int main(int argc, const char * argv[]) {
         
         
 
-        float maxX ;
-        float minX ;
-        float maxZ ;
-        float minZ ;
-        float maxY ;
-        float minY ;
-        for(int i = 0; i < sphereDatas.size(); ++i){
-            Vector3 pos = sphereDatas[i].phys.GetPosition();
-            Vector3 prePos = sphereDatas[i].phys.GetPrePos();
-
-             maxX = threshold;
-             minX = threshold;
-             maxZ = threshold;
-             minZ = threshold;
-            maxY = threshold;
-            minY = threshold;
-            if(pos.x > prePos.x){
-                maxX += pos.x + sphereDatas[i].collision.radius;
-                minX += prePos.x - sphereDatas[i].collision.radius;
-            }
-            else {
-                maxX += prePos.x + sphereDatas[i].collision.radius;
-                minX += pos.x - sphereDatas[i].collision.radius;
-            }
-            if(pos.y > prePos.y){
-                maxY += pos.y + sphereDatas[i].collision.radius;
-                minY += prePos.y - sphereDatas[i].collision.radius;
-            }
-            else {
-                maxY += prePos.y + sphereDatas[i].collision.radius;
-                minY += pos.y - sphereDatas[i].collision.radius;
-            }
-            if(pos.z > prePos.z){
-                maxZ += pos.z + sphereDatas[i].collision.radius;
-                minZ += prePos.z - sphereDatas[i].collision.radius;
-            }
-            else {
-                maxZ += prePos.z + sphereDatas[i].collision.radius;
-                minZ += pos.z - sphereDatas[i].collision.radius;
-            }
-            float rate = 1 / threshold;
-            maxX *= rate;
-            minX *= rate;
-            maxY *= rate;
-            minY *= rate;
-            maxZ *= rate;
-            minZ *= rate;
-
-            Clamp(maxX, 0.0f, 1.0f);
-            Clamp(minX, 0.0f, 1.0f);
-            Clamp(maxY, 0.0f, 1.0f);
-            Clamp(minY, 0.0f, 1.0f);
-            Clamp(maxZ, 0.0f, 1.0f);
-            Clamp(minZ, 0.0f, 1.0f);
-
-            int maxIdx = (int)maxX + (int)maxY * 2 + (int)maxZ * 4;
-            int minIdx = (int)minX + (int)minY * 2 + (int)minZ * 4;
-            if(maxIdx == minIdx){
-                splitter[maxIdx].AddItem(&sphereDatas[i]);
-            }
-            else {
-                splitter[8].AddItem(&sphereDatas[i]);
-            }
-        }
-
-        for(auto& split : splitter){
-            for(int i = 0; i < split.ItemNum(); ++i){
-                for(int j = i + 1; j < split.ItemNum(); ++j){
-                    CulcFix(delta, (*split[i]), (*split[j]));
-                }
-            }
-        }
-        for(int i = 0; i < splitter.size() - 1; ++i){
-            for(int j = 0; j < splitter[8].ItemNum(); ++j){
-                auto& rhs = splitter[i].GetItems();
-                for(int k = 0; k < rhs.size(); ++k){
-                    CulcFix(delta, *splitter[8][j], *rhs[k]);
-                }
-            }
-            splitter[i].Clear();
-        }
-        splitter[8].Clear();
-        
-        
-        for(int i = 0; i < sphereDatas.size(); ++i){
-            for(int j = i + 1; j < sphereDatas.size(); ++j){
-                CulcFix(delta, sphereDatas[i], sphereDatas[j]);
-            }
-        }
-
-        for(int i = 0; i < capDatas.size(); ++i){
-            for(int j = i + 1; j < capDatas.size(); ++j){
-                CulcFix(delta, capDatas[i], capDatas[j]);
-            }
-        }
-
-        for(int i = 0; i < sphereDatas.size(); ++i){
-            for(int j = 0; j < capDatas.size(); ++j){
-                CulcFix(delta, sphereDatas[i], capDatas[j]);
-            }
-        }
-        
-        for(auto& data : sphereDatas){
-            data.phys.PreFix();
-        }
-        for(auto& data : capDatas){
-            data.phys.PreFix();
-        }
         
 
         
@@ -1275,13 +1168,6 @@ int main(int argc, const char * argv[]) {
 //        }
         
         
-        auto mapFixFunc = [](float delta, auto& datas, auto& walls){
-            for(auto& data : datas){
-                for(auto& wall : walls){
-                    CulcMapFix(delta, data, wall);
-                }
-            }
-        };
 
         
         
@@ -1299,20 +1185,6 @@ int main(int argc, const char * argv[]) {
 //            }
 //        }
         
-        mapFixFunc(delta,sphereDatas,cubeCollisions);
-        mapFixFunc(delta,capDatas,cubeCollisions);
-        mapFixFunc(delta,sphereDatas,walls);
-        mapFixFunc(delta,capDatas,walls);
-
-        if(!skip){
-            for(auto& data : sphereDatas){
-                data.phys.Fix();
-            }
-            
-            for(auto& data : capDatas){
-                data.phys.Fix();
-            }
-        }
         //mapFixFunc(delta,capDatas,cubeCollisions);
         
         auto cubeHitCheck = [&](auto& data, auto& mesh){
@@ -1334,48 +1206,36 @@ int main(int argc, const char * argv[]) {
         };
         
 
-        //std::cout << "time is : ";
-        //std::cout << end - start << std::endl;
-        
+        //球とカプセルはインスタンス描画なので位置を入れるだけ(Draw でまとめて送る)
         Vector3 pos;
         for(int i = 0; i < spheres.size(); ++i){
-            pos = sphereDatas[i].phys.GetPosition();
-            sphereDatas[i].collision.position = pos;
+            pos = world.GetRenderPosition(sphereDatas[i].body);
             spheres[i]->SetPosition(pos);
-            drawer.Update(spheres[i]);
-            spheres[i]->SetColor(defaultColor);
         }
-        
         for(int i = 0; i < caps.size(); ++i){
-            pos = capDatas[i].phys.GetPosition();
-            capDatas[i].collision.s.p = pos;
+            pos = world.GetRenderPosition(capDatas[i].body);
             caps[i]->SetPosition(pos);
-            drawer.Update(caps[i]);
-            caps[i]->SetColor(defaultColor);
         }
         
-        clock_t start = clock();
-        cubeHitCheck(sphereDatas,spheres);
-        cubeHitCheck(capDatas,caps);
-        clock_t end = clock();
-        
-        for(auto& capmesh : caps){
-            drawer.Update(capmesh);
+        {
+            PROFILE_ZONE("CubeHitCheck");
+            cubeHitCheck(sphereDatas,spheres);
+            cubeHitCheck(capDatas,caps);
         }
         
-        for(int i = 0; i < 6; ++i){
-            drawer.Update(cubes[i]);
-        }
- 
-        for(int i = 0; i < cubeMeshes.size(); ++i){
-            drawer.Update(cubeMeshes[i]);
-            cubeMeshes[i]->SetColor(defaultColor);
+        {
+            PROFILE_ZONE("DrawUpload");
+            //壁(cubes)は動かないので送らない. 箱は当たったときの色だけ変わる
+            for(int i = 0; i < cubeMeshes.size(); ++i){
+                drawer.Update(cubeMeshes[i]);
+                cubeMeshes[i]->SetColor(defaultColor);
+            }
         }
         
         Vector3 distance = camera.GetOrientation() * -35.0f;
         distance.y += 5.0f;
         if(!cameraMove){
-            camera.SetPosition(sphereDatas[1].phys.GetPosition() + distance);
+            camera.SetPosition(world.GetRenderPosition(sphereDatas[1].body) + distance);
         }
         
         /*
@@ -1386,7 +1246,17 @@ int main(int argc, const char * argv[]) {
         const Matrix4x4 matView = camera.GetViewMat();//LookAt(camera.GetPosition(), camera + cameraPosition, UpVector);
         const Matrix4x4 matProj = Perspective(M_PI_4, windowY / windowX, 0.1, 10000.0f);
         fromWindowToWorld = Inverse(matView);
-        drawer.Draw(matProj * matView);
+        {
+            PROFILE_ZONE("Draw");
+            drawer.Draw(matProj * matView);
+        }
+        //当たった色は描いたあとで戻す
+        for(auto& sphere : spheres){
+            sphere->SetColor(defaultColor);
+        }
+        for(auto& capmesh : caps){
+            capmesh->SetColor(defaultColor);
+        }
         
         
         // サイト表示
@@ -1398,6 +1268,7 @@ int main(int argc, const char * argv[]) {
         
         glfwPollEvents();
         glfwSwapBuffers(window);
+        Profiler::Instance().EndFrame();
     }
     
     glDeleteShader(shader);
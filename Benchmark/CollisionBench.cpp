@@ -0,0 +1,583 @@
+//
+//  CollisionBench.cpp
+//  3DCollision
+//
+//  Created by Tomoya Fujii on 2018/02/01.
+//  Copyright © 2018年 TomoyaFujii. All rights reserved.
+//
+
+//Collision.h / Physics.h の判定関数を1つずつ計測する.
+//  入力は seed 固定の乱数で作り, 分布ごと(hit / miss / parallel)に ns/call と calls/sec を出す.
+//  結果は JSON で標準出力(--out で指定したファイル)へ, 読みやすい表は標準エラーへ出す.
+//
+//  CollisionBench [--seed N] [--count N] [--min-ms N] [--filter text] [--out file]
+
+#include "Collision.h"
+#include "Physics.h"
+#include "ConvexCollision.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace myTools;
+
+namespace {
+
+    enum class Distribution {
+        //ほとんど当たる
+        Hit,
+        //ほとんど当たらない
+        Miss,
+        //線分・軸・面がほぼ平行(判定の分岐や誤差が一番厳しいところ)
+        NearParallel,
+    };
+
+    const char* GetName(Distribution dist){
+        switch(dist){
+            case Distribution::Hit:             return "hit";
+            case Distribution::Miss:            return "miss";
+            case Distribution::NearParallel:    return "parallel";
+        }
+        return "";
+    }
+
+    /**
+     *  @tips   Makes random shapes for one distribution.
+     *          slot 0 is the lhs, slot 1 the rhs. For Miss the rhs is moved far away.
+     */
+    class Generator {
+    public:
+        Generator(unsigned int seed, Distribution dist) : engine(seed), dist(dist){}
+
+        float Range(float min, float max){
+            return std::uniform_real_distribution<float>(min, max)(engine);
+        }
+        Vector3 InBox(float half){
+            return Vector3(Range(-half, half), Range(-half, half), Range(-half, half));
+        }
+        Vector3 Center(int slot){
+            Vector3 center = InBox(1.0f);
+            if(dist == Distribution::Miss && slot == 1){
+                center += Vector3(40.0f, 40.0f, 40.0f);
+            }
+            return center;
+        }
+        //線分や軸の向き. parallel では x 軸から 1e-4 程度しかずらさない
+        Vector3 Direction(){
+            if(dist == Distribution::NearParallel){
+                return Normalize(Vector3(1.0f, 0.0f, 0.0f) + InBox(1e-4f));
+            }
+            Vector3 dir;
+            do {
+                dir = InBox(1.0f);
+            } while(dir.LengthSq() < 0.01f);
+            return Normalize(dir);
+        }
+        //面の法線. parallel では線分と平行な面になるよう y 軸の近くにする
+        Vector3 Normal(){
+            if(dist == Distribution::NearParallel){
+                return Normalize(Vector3(0.0f, 1.0f, 0.0f) + InBox(1e-4f));
+            }
+            return Direction();
+        }
+        //面に沿った2方向
+        void Tangents(const Vector3& normal, Vector3& u, Vector3& w){
+            Vector3 axis = fabsf(normal.x) < 0.9f ? Vector3(1.0f, 0.0f, 0.0f) : Vector3(0.0f, 0.0f, 1.0f);
+            u = Normalize(cross(normal, axis));
+            w = cross(normal, u);
+        }
+        //動く物体の移動量
+        Vector3 Move(int slot){
+            if(dist == Distribution::NearParallel){
+                return Direction() * 3.0f;
+            }
+            if(dist == Distribution::Miss){
+                return InBox(1.0f);
+            }
+            //お互いに近づく方向へ動かす
+            Vector3 toward(2.0f, 2.0f, 2.0f);
+            return (slot == 0 ? toward : -toward) + InBox(1.0f);
+        }
+
+    private:
+        std::mt19937 engine;
+        Distribution dist;
+    };
+
+    void Make(Generator& gen, int slot, Point& point){
+        point = gen.Center(slot);
+    }
+    void Make(Generator& gen, int slot, Line& line){
+        line = Line(gen.Center(slot), gen.Direction() * gen.Range(1.0f, 4.0f));
+    }
+    void Make(Generator& gen, int slot, Segment& segment){
+        Vector3 v = gen.Direction() * gen.Range(2.0f, 6.0f);
+        segment = Segment(gen.Center(slot) - v * 0.5f, v);
+    }
+    void Make(Generator& gen, int slot, PlaneCollision& plane){
+        plane = PlaneCollision(gen.Center(slot), gen.Normal());
+    }
+    void Make(Generator& gen, int slot, PolygonCollision& polygon){
+        Vector3 center = gen.Center(slot);
+        Vector3 u, w;
+        gen.Tangents(gen.Normal(), u, w);
+        float size = gen.Range(2.0f, 4.0f);
+        polygon = PolygonCollision(center - u * size - w * size, center + u * size - w * size, center + w * size);
+    }
+    void Make(Generator& gen, int slot, SquareCollision& square){
+        Vector3 center = gen.Center(slot);
+        Vector3 u, w;
+        gen.Tangents(gen.Normal(), u, w);
+        u *= gen.Range(1.0f, 3.0f);
+        w *= gen.Range(1.0f, 3.0f);
+        square = SquareCollision(center - u - w, center + u - w, center + u + w, center - u + w);
+    }
+    void Make(Generator& gen, int slot, AABBCollision& aabb){
+        Vector3 center = gen.Center(slot);
+        Vector3 half(gen.Range(0.5f, 2.0f), gen.Range(0.5f, 2.0f), gen.Range(0.5f, 2.0f));
+        aabb.min = center - half;
+        aabb.max = center + half;
+    }
+    void Make(Generator& gen, int slot, CubeCollision& cube){
+        cube.position = gen.Center(slot);
+        //parallel では lhs と rhs の軸がほぼ揃う
+        cube.direct[0] = gen.Direction();
+        gen.Tangents(cube.direct[0], cube.direct[1], cube.direct[2]);
+        cube.scale = Vector3(gen.Range(0.5f, 2.0f), gen.Range(0.5f, 2.0f), gen.Range(0.5f, 2.0f));
+    }
+    void Make(Generator& gen, int slot, SphereCollision& sphere){
+        sphere = SphereCollision(gen.Range(0.5f, 2.0f), gen.Center(slot));
+    }
+    void Make(Generator& gen, int slot, CylinderCollision& cylinder){
+        Line line;
+        Make(gen, slot, line);
+        cylinder = CylinderCollision(gen.Range(0.5f, 1.5f), line);
+    }
+    void Make(Generator& gen, int slot, CapsuleCollision& capsule){
+        Vector3 v = gen.Direction() * gen.Range(2.0f, 5.0f);
+        capsule = CapsuleCollision(gen.Range(0.5f, 1.5f), gen.Center(slot) - v * 0.5f, v);
+    }
+    void Make(Generator& gen, int slot, DomeCollision& dome){
+        dome.position = gen.Center(slot);
+        dome.minRadius = gen.Range(3.0f, 5.0f);
+        dome.maxRadius = dome.minRadius + gen.Range(1.0f, 3.0f);
+    }
+
+    Vector3 GetPosition(const SphereCollision& sphere){
+        return sphere.position;
+    }
+    Vector3 GetPosition(const CylinderCollision& cylinder){
+        return cylinder.line.p;
+    }
+    Vector3 GetPosition(const CapsuleCollision& capsule){
+        return capsule.s.p;
+    }
+    Vector3 GetPosition(const CubeCollision& cube){
+        return cube.position;
+    }
+
+    template<typename Ty>
+    void Make(Generator& gen, int slot, MoveCollData<Ty>& data){
+        Make(gen, slot, data.collision);
+        Vector3 pos = GetPosition(data.collision);
+        data.phys.SetPosition(pos, false);
+        data.phys.SetPrePos(pos + gen.Move(slot));
+    }
+
+    /**
+     *  @tips   For Hit, moves rhs so that it touches lhs.
+     *          Only pairs that random shapes (almost) never hit, like point / line, are placed.
+     */
+    template<typename A, typename B>
+    void Touch(Generator&, const A&, B&){
+    }
+    //三角形の中の点
+    Vector3 Inside(Generator& gen, const PolygonCollision& polygon){
+        float w[3] = { gen.Range(0.1f, 1.0f), gen.Range(0.1f, 1.0f), gen.Range(0.1f, 1.0f) };
+        float sum = w[0] + w[1] + w[2];
+        return (polygon.p[0] * w[0] + polygon.p[1] * w[1] + polygon.p[2] * w[2]) / sum;
+    }
+    //長方形の中の点
+    Vector3 Inside(Generator& gen, const SquareCollision& square){
+        float u = gen.Range(0.1f, 0.9f);
+        float w = gen.Range(0.1f, 0.9f);
+        return square.p[0] + (square.p[1] - square.p[0]) * u + (square.p[3] - square.p[0]) * w;
+    }
+    void Touch(Generator&, const Point& lhs, Point& rhs){
+        rhs = lhs;
+    }
+    void Touch(Generator& gen, const Point& lhs, Line& rhs){
+        rhs.p = lhs - rhs.v * gen.Range(-1.0f, 1.0f);
+    }
+    void Touch(Generator& gen, const Line& lhs, Point& rhs){
+        rhs = lhs.p + lhs.v * gen.Range(-1.0f, 1.0f);
+    }
+    void Touch(Generator& gen, const Point& lhs, Segment& rhs){
+        rhs.p = lhs - rhs.v * gen.Range(0.05f, 0.95f);
+    }
+    void Touch(Generator& gen, const Segment& lhs, Point& rhs){
+        rhs = lhs.p + lhs.v * gen.Range(0.05f, 0.95f);
+    }
+    //lhs の上の点を通るようにする
+    void Touch(Generator& gen, const Line& lhs, Line& rhs){
+        rhs.p = lhs.p + lhs.v * gen.Range(-1.0f, 1.0f) - rhs.v * gen.Range(-1.0f, 1.0f);
+    }
+    void Touch(Generator& gen, const Point& lhs, PolygonCollision& rhs){
+        Vector3 offset = lhs - Inside(gen, rhs);
+        rhs = PolygonCollision(rhs.p[0] + offset, rhs.p[1] + offset, rhs.p[2] + offset);
+    }
+    void Touch(Generator& gen, const PolygonCollision& lhs, Point& rhs){
+        rhs = Inside(gen, lhs);
+    }
+    void Touch(Generator& gen, const Point& lhs, SquareCollision& rhs){
+        Vector3 offset = lhs - Inside(gen, rhs);
+        rhs = SquareCollision(rhs.p[0] + offset, rhs.p[1] + offset, rhs.p[2] + offset, rhs.p[3] + offset);
+    }
+    void Touch(Generator& gen, const SquareCollision& lhs, Point& rhs){
+        rhs = Inside(gen, lhs);
+    }
+
+    //戻り値を当たったかどうかと最適化よけの値にする
+    bool IsHit(bool hit){
+        return hit;
+    }
+    bool IsHit(float){
+        return false;
+    }
+    bool IsHit(const CollisionData& data){
+        return data.hit;
+    }
+    bool IsHit(const HitData& data){
+        return data.hit;
+    }
+    bool IsHit(const ConvexHitData& data){
+        return data.hit;
+    }
+    float ToSink(bool hit){
+        return hit ? 1.0f : 0.0f;
+    }
+    float ToSink(float value){
+        return value;
+    }
+    float ToSink(const CollisionData& data){
+        return data.position.x;
+    }
+    float ToSink(const HitData& data){
+        return data.time;
+    }
+    float ToSink(const ConvexHitData& data){
+        return data.distance;
+    }
+
+    volatile float sink = 0.0f;
+
+    struct Result {
+        std::string name;
+        Distribution dist;
+        double nsPerCall;
+        double callsPerSec;
+        //距離関数は当たり判定ではないので -1 (JSON では null)
+        double hitRate;
+        long long calls;
+    };
+
+    struct Options {
+        unsigned int seed = 20180201;
+        int count = 4096;
+        double minMs = 20.0;
+        std::string filter;
+        std::string out;
+    };
+
+    class Runner {
+    public:
+        explicit Runner(const Options& options) : options(options){}
+
+        template<typename A, typename B, typename Func>
+        void Run(const std::string& name, Func func){
+            if(!options.filter.empty() && name.find(options.filter) == std::string::npos){
+                return;
+            }
+            const Distribution dists[] = { Distribution::Hit, Distribution::Miss, Distribution::NearParallel };
+            for(Distribution dist : dists){
+                Generator gen(options.seed, dist);
+                std::vector<A> lhs(options.count);
+                std::vector<B> rhs(options.count);
+                for(int i = 0; i < options.count; ++i){
+                    Make(gen, 0, lhs[i]);
+                    Make(gen, 1, rhs[i]);
+                    if(dist == Distribution::Hit){
+                        Touch(gen, lhs[i], rhs[i]);
+                    }
+                }
+
+                //1周目はキャッシュを温めるのと当たった数を数えるため
+                int hitCount = 0;
+                bool isFlag = false;
+                for(int i = 0; i < options.count; ++i){
+                    auto ret = func(lhs[i], rhs[i]);
+                    isFlag = !std::is_same<decltype(ret), float>::value;
+                    hitCount += IsHit(ret) ? 1 : 0;
+                }
+
+                typedef std::chrono::steady_clock Clock;
+                long long calls = 0;
+                float total = 0.0f;
+                Clock::time_point start = Clock::now();
+                double elapsedNs = 0.0;
+                do {
+                    for(int i = 0; i < options.count; ++i){
+                        total += ToSink(func(lhs[i], rhs[i]));
+                    }
+                    calls += options.count;
+                    elapsedNs = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+                } while(elapsedNs < options.minMs * 1e6);
+                sink = sink + total;
+
+                Result result;
+                result.name = name;
+                result.dist = dist;
+                result.nsPerCall = elapsedNs / calls;
+                result.callsPerSec = calls / (elapsedNs * 1e-9);
+                result.hitRate = isFlag ? (double)hitCount / options.count : -1.0;
+                result.calls = calls;
+                results.push_back(result);
+                fprintf(stderr, "%-72s %-8s %10.2f ns %14.0f /s", name.c_str(), GetName(dist),
+                        result.nsPerCall, result.callsPerSec);
+                if(isFlag){
+                    fprintf(stderr, "  hit %6.1f%%", result.hitRate * 100.0);
+                }
+                fprintf(stderr, "\n");
+            }
+        }
+
+        void WriteJson(FILE* file) const {
+            fprintf(file, "{\n  \"seed\": %u,\n  \"count\": %d,\n  \"results\": [\n", options.seed, options.count);
+            for(size_t i = 0; i < results.size(); ++i){
+                const Result& r = results[i];
+                char hitRate[32] = "null";
+                if(r.hitRate >= 0.0){
+                    snprintf(hitRate, sizeof(hitRate), "%.4f", r.hitRate);
+                }
+                fprintf(file, "    {\"name\": \"%s\", \"distribution\": \"%s\", \"ns_per_call\": %.3f, "
+                        "\"calls_per_sec\": %.0f, \"hit_rate\": %s, \"calls\": %lld}%s\n",
+                        r.name.c_str(), GetName(r.dist), r.nsPerCall, r.callsPerSec, hitRate, r.calls,
+                        i + 1 < results.size() ? "," : "");
+            }
+            fprintf(file, "  ]\n}\n");
+        }
+
+    private:
+        Options options;
+        std::vector<Result> results;
+    };
+}
+
+#define BENCH(Func, A, B) \
+    runner.Run<A, B>(#Func "(" #A ", " #B ")", [](const A& a, const B& b){ return Func(a, b); })
+
+int main(int argc, const char* argv[]){
+    Options options;
+    for(int i = 1; i + 1 < argc; i += 2){
+        if(strcmp(argv[i], "--seed") == 0){
+            options.seed = (unsigned int)strtoul(argv[i + 1], nullptr, 10);
+        }
+        else if(strcmp(argv[i], "--count") == 0){
+            options.count = atoi(argv[i + 1]);
+        }
+        else if(strcmp(argv[i], "--min-ms") == 0){
+            options.minMs = atof(argv[i + 1]);
+        }
+        else if(strcmp(argv[i], "--filter") == 0){
+            options.filter = argv[i + 1];
+        }
+        else if(strcmp(argv[i], "--out") == 0){
+            options.out = argv[i + 1];
+        }
+    }
+    if(options.count < 1){
+        options.count = 1;
+    }
+
+    Runner runner(options);
+
+    BENCH(Distance, Point, Point);
+    BENCH(Distance, Point, Line);
+    BENCH(Distance, Line, Point);
+    BENCH(DistanceSq, Point, Line);
+    BENCH(DistanceSq, Line, Point);
+    BENCH(Distance, Point, Segment);
+    BENCH(Distance, Segment, Point);
+    BENCH(DistanceSq, Point, Segment);
+    BENCH(DistanceSq, Segment, Point);
+    BENCH(Distance, Point, PlaneCollision);
+    BENCH(Distance, PlaneCollision, Point);
+    BENCH(DistanceSq, Point, SquareCollision);
+    BENCH(DistanceSq, SquareCollision, Point);
+    BENCH(Distance, Line, Line);
+    BENCH(DistanceSq, Line, Line);
+    BENCH(Distance, Line, Segment);
+    BENCH(Distance, Segment, Line);
+    BENCH(DistanceSq, Line, Segment);
+    BENCH(DistanceSq, Segment, Line);
+    BENCH(Distance, Segment, Segment);
+    BENCH(DistanceSq, Segment, Segment);
+    BENCH(Distance, Segment, PlaneCollision);
+    BENCH(Distance, PlaneCollision, Segment);
+    BENCH(CollisionReturnFlag, Point, Point);
+    BENCH(CollisionReturnFlag, Point, Line);
+    BENCH(CollisionReturnFlag, Line, Point);
+    BENCH(CollisionReturnFlag, Point, Segment);
+    BENCH(CollisionReturnFlag, Segment, Point);
+    BENCH(CollisionReturnFlag, Line, Line);
+    BENCH(Collision, Line, Line);
+    BENCH(CollisionReturnFlag, PlaneCollision, Line);
+    BENCH(CollisionReturnFlag, Line, PlaneCollision);
+    BENCH(Collision, PlaneCollision, Line);
+    BENCH(Collision, Line, PlaneCollision);
+    BENCH(CollisionReturnFlag, PlaneCollision, Segment);
+    BENCH(CollisionReturnFlag, Segment, PlaneCollision);
+    BENCH(Collision, PlaneCollision, Segment);
+    BENCH(Collision, Segment, PlaneCollision);
+    BENCH(CollisionReturnFlag, PolygonCollision, Point);
+    BENCH(CollisionReturnFlag, Point, PolygonCollision);
+    BENCH(CollisionReturnFlag, PolygonCollision, Line);
+    BENCH(CollisionReturnFlag, Line, PolygonCollision);
+    BENCH(Collision, PolygonCollision, Line);
+    BENCH(Collision, Line, PolygonCollision);
+    BENCH(CollisionReturnFlag, PolygonCollision, Segment);
+    BENCH(CollisionReturnFlag, Segment, PolygonCollision);
+    BENCH(Collision, PolygonCollision, Segment);
+    BENCH(Collision, Segment, PolygonCollision);
+    BENCH(CollisionReturnFlag, SquareCollision, Point);
+    BENCH(CollisionReturnFlag, Point, SquareCollision);
+    BENCH(CollisionReturnFlag, SquareCollision, Line);
+    BENCH(CollisionReturnFlag, Line, SquareCollision);
+    BENCH(Collision, SquareCollision, Line);
+    BENCH(Collision, Line, SquareCollision);
+    BENCH(CollisionReturnFlag, SquareCollision, Segment);
+    BENCH(CollisionReturnFlag, Segment, SquareCollision);
+    BENCH(Collision, SquareCollision, Segment);
+    BENCH(Collision, Segment, SquareCollision);
+    BENCH(CollisionReturnFlag, SquareCollision, SphereCollision);
+    BENCH(CollisionReturnFlag, SphereCollision, SquareCollision);
+    BENCH(CollisionReturnFlag, SquareCollision, CylinderCollision);
+    BENCH(CollisionReturnFlag, CylinderCollision, SquareCollision);
+    BENCH(CollisionReturnFlag, SquareCollision, CapsuleCollision);
+    BENCH(CollisionReturnFlag, CapsuleCollision, SquareCollision);
+    BENCH(CollisionReturnFlag, SphereCollision, SphereCollision);
+    BENCH(CollisionReturnFlag, SphereCollision, Point);
+    BENCH(CollisionReturnFlag, Point, SphereCollision);
+    BENCH(CollisionReturnFlag, SphereCollision, Line);
+    BENCH(CollisionReturnFlag, Line, SphereCollision);
+    BENCH(Collision, SphereCollision, Line);
+    BENCH(Collision, Line, SphereCollision);
+    BENCH(CollisionReturnFlag, SphereCollision, Segment);
+    BENCH(CollisionReturnFlag, Segment, SphereCollision);
+    BENCH(Collision, SphereCollision, Segment);
+    BENCH(Collision, Segment, SphereCollision);
+    BENCH(CollisionReturnFlag, SphereCollision, PlaneCollision);
+    BENCH(CollisionReturnFlag, PlaneCollision, SphereCollision);
+    BENCH(CollisionReturnFlag, SphereCollision, PolygonCollision);
+    BENCH(CollisionReturnFlag, PolygonCollision, SphereCollision);
+    BENCH(CollisionReturnFlag, CylinderCollision, CylinderCollision);
+    BENCH(CollisionReturnFlag, CylinderCollision, Line);
+    BENCH(CollisionReturnFlag, Line, CylinderCollision);
+    BENCH(CollisionReturnFlag, CylinderCollision, Segment);
+    BENCH(CollisionReturnFlag, Segment, CylinderCollision);
+    BENCH(CollisionReturnFlag, CylinderCollision, SphereCollision);
+    BENCH(CollisionReturnFlag, SphereCollision, CylinderCollision);
+    BENCH(CollisionReturnFlag, CapsuleCollision, CapsuleCollision);
+    BENCH(CollisionReturnFlag, CapsuleCollision, Point);
+    BENCH(CollisionReturnFlag, Point, CapsuleCollision);
+    BENCH(CollisionReturnFlag, CapsuleCollision, Line);
+    BENCH(CollisionReturnFlag, Line, CapsuleCollision);
+    BENCH(Collision, CapsuleCollision, Line);
+    BENCH(Collision, Line, CapsuleCollision);
+    BENCH(CollisionReturnFlag, CapsuleCollision, Segment);
+    BENCH(CollisionReturnFlag, Segment, CapsuleCollision);
+    BENCH(Collision, CapsuleCollision, Segment);
+    BENCH(Collision, Segment, CapsuleCollision);
+    BENCH(CollisionReturnFlag, CapsuleCollision, PlaneCollision);
+    BENCH(CollisionReturnFlag, PlaneCollision, CapsuleCollision);
+    BENCH(CollisionReturnFlag, SphereCollision, CapsuleCollision);
+    BENCH(CollisionReturnFlag, CapsuleCollision, SphereCollision);
+    BENCH(CollisionReturnFlag, AABBCollision, Point);
+    BENCH(CollisionReturnFlag, Point, AABBCollision);
+    BENCH(CollisionReturnFlag, AABBCollision, Line);
+    BENCH(CollisionReturnFlag, Line, AABBCollision);
+    BENCH(Collision, AABBCollision, Line);
+    BENCH(Collision, Line, AABBCollision);
+    BENCH(CollisionReturnFlag, AABBCollision, Segment);
+    BENCH(CollisionReturnFlag, Segment, AABBCollision);
+    BENCH(Collision, AABBCollision, Segment);
+    BENCH(Collision, Segment, AABBCollision);
+    BENCH(CollisionReturnFlag, AABBCollision, SphereCollision);
+    BENCH(CollisionReturnFlag, SphereCollision, AABBCollision);
+    BENCH(CollisionReturnFlag, AABBCollision, CapsuleCollision);
+    BENCH(CollisionReturnFlag, CapsuleCollision, AABBCollision);
+    BENCH(CollisionReturnFlag, AABBCollision, AABBCollision);
+    BENCH(CollisionReturnFlag, CubeCollision, SphereCollision);
+    BENCH(CollisionReturnFlag, CubeCollision, CapsuleCollision);
+    BENCH(CollisionReturnFlag, CubeCollision, CubeCollision);
+    //上と同じ組み合わせを GJK / EPA で
+    BENCH(ConvexCollision, SphereCollision, SphereCollision);
+    BENCH(ConvexCollision, CapsuleCollision, CapsuleCollision);
+    BENCH(ConvexCollision, CylinderCollision, CylinderCollision);
+    BENCH(ConvexCollision, CapsuleCollision, SquareCollision);
+    BENCH(ConvexCollision, AABBCollision, SphereCollision);
+    BENCH(ConvexCollision, AABBCollision, CapsuleCollision);
+    BENCH(ConvexCollision, AABBCollision, AABBCollision);
+    BENCH(ConvexCollision, CubeCollision, CubeCollision);
+    BENCH(MoveCollision, MoveCollData<SphereCollision>, MoveCollData<SphereCollision>);
+    BENCH(MoveCollision, MoveCollData<CylinderCollision>, MoveCollData<CylinderCollision>);
+    BENCH(MoveCollision, MoveCollData<SphereCollision>, MoveCollData<CylinderCollision>);
+    BENCH(MoveCollision, MoveCollData<CylinderCollision>, MoveCollData<SphereCollision>);
+    BENCH(MoveCollision, MoveCollData<CylinderCollision>, MoveCollData<CapsuleCollision>);
+    BENCH(MoveCollision, MoveCollData<CapsuleCollision>, MoveCollData<CylinderCollision>);
+    BENCH(MoveCollision, MoveCollData<SphereCollision>, MoveCollData<CapsuleCollision>);
+    BENCH(MoveCollision, MoveCollData<CapsuleCollision>, MoveCollData<SphereCollision>);
+    BENCH(MoveCollision, MoveCollData<CapsuleCollision>, MoveCollData<CapsuleCollision>);
+    BENCH(MoveCollision, MoveCollData<CubeCollision>, MoveCollData<CubeCollision>);
+    BENCH(StaticCollision, MoveCollData<SphereCollision>, Point);
+    BENCH(StaticCollision, MoveCollData<SphereCollision>, Line);
+    BENCH(StaticCollision, MoveCollData<SphereCollision>, Segment);
+    BENCH(StaticCollision, MoveCollData<SphereCollision>, PlaneCollision);
+    BENCH(StaticCollision, MoveCollData<CylinderCollision>, Point);
+    BENCH(StaticCollision, MoveCollData<CylinderCollision>, Line);
+    BENCH(StaticCollision, MoveCollData<CylinderCollision>, Segment);
+    BENCH(StaticCollision, MoveCollData<CylinderCollision>, PlaneCollision);
+    BENCH(StaticCollision, MoveCollData<CapsuleCollision>, PlaneCollision);
+    BENCH(StaticCollision, MoveCollData<SphereCollision>, SquareCollision);
+    BENCH(StaticCollision, MoveCollData<CylinderCollision>, SquareCollision);
+    BENCH(StaticCollision, MoveCollData<CapsuleCollision>, SquareCollision);
+    BENCH(StaticCollision, MoveCollData<SphereCollision>, AABBCollision);
+    BENCH(StaticCollision, MoveCollData<CylinderCollision>, AABBCollision);
+    BENCH(StaticCollision, MoveCollData<CapsuleCollision>, AABBCollision);
+    BENCH(StaticCollision, MoveCollData<SphereCollision>, SphereCollision);
+    BENCH(StaticCollision, MoveCollData<SphereCollision>, DomeCollision);
+    BENCH(StaticCollision, MoveCollData<CapsuleCollision>, DomeCollision);
+    BENCH(StaticCollision, MoveCollData<SphereCollision>, CubeCollision);
+    BENCH(StaticCollision, MoveCollData<CapsuleCollision>, CubeCollision);
+    BENCH(StaticCollision, MoveCollData<CubeCollision>, CubeCollision);
+
+    FILE* file = stdout;
+    if(!options.out.empty()){
+        file = fopen(options.out.c_str(), "w");
+        if(!file){
+            fprintf(stderr, "cannot open %s\n", options.out.c_str());
+            return 1;
+        }
+    }
+    runner.WriteJson(file);
+    if(file != stdout){
+        fclose(file);
+    }
+    return 0;
+}